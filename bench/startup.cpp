@@ -0,0 +1,211 @@
+/*
+ * Times the startup of wcm against a synthetic metadata directory.
+ *
+ * Usage: wcm-startup-bench [plugins] [options per plugin]
+ *
+ * The metadata directory, a matching wayfire.ini and the cache directory are
+ * generated in a temporary directory, so every run starts cold. The metadata
+ * and plugin tree are loaded without WCM, so they are measured without a
+ * display too. The results are printed as a single JSON object on stdout.
+ * Phases that need GTK are skipped when no display is available.
+ */
+#include <wcm.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+namespace
+{
+using bench_clock = std::chrono::steady_clock;
+
+const char *OPTION_TYPES[] = {"int", "double", "bool", "string", "key", "activator", "color"};
+
+std::string plugin_name(int i)
+{
+    return "bench" + std::to_string(i);
+}
+
+void write_option(std::ofstream & out, int plugin, int option)
+{
+    const std::string type = OPTION_TYPES[option % std::size(OPTION_TYPES)];
+    out << "    <option name=\"option" << option << "\" type=\"" << type << "\">\n" <<
+        "      <_short>Option " << option << "</_short>\n" <<
+        "      <_long>Synthetic option " << option << " of plugin " << plugin << "</_long>\n";
+    if (type == "int")
+    {
+        out << "      <default>1</default>\n      <min>0</min>\n      <max>2</max>\n";
+        for (int i = 0; i < 3; i++)
+        {
+            out << "      <desc><value>" << i << "</value><_name>Value " << i << "</_name></desc>\n";
+        }
+    } else if (type == "double")
+    {
+        out << "      <default>0.5</default>\n      <min>0.0</min>\n      <max>1.0</max>\n" <<
+            "      <precision>0.01</precision>\n";
+    } else if (type == "bool")
+    {
+        out << "      <default>true</default>\n";
+    } else if (type == "string")
+    {
+        out << "      <default>value</default>\n";
+    } else if (type == "key")
+    {
+        out << "      <default>&lt;super&gt; KEY_" << (char)('A' + option % 26) << "</default>\n";
+    } else if (type == "activator")
+    {
+        out << "      <default>&lt;super&gt; BTN_LEFT</default>\n";
+    } else
+    {
+        out << "      <default>0.0 0.0 0.0 1.0</default>\n";
+    }
+
+    out << "    </option>\n";
+}
+
+/* Half of the options of each plugin are top-level, the other half live in a
+ * group with a subgroup, like the larger wayfire plugins. */
+void generate(const std::string & xmldir, const std::string & ini, int plugins, int options)
+{
+    std::filesystem::create_directories(xmldir);
+    std::ofstream config(ini);
+    config << "[core]\nplugins =";
+    for (int i = 0; i < plugins; i++)
+    {
+        config << " " << plugin_name(i);
+    }
+
+    config << "\n";
+    for (int i = 0; i < plugins; i++)
+    {
+        std::ofstream out(xmldir + "/" + plugin_name(i) + ".xml");
+        out << "<?xml version=\"1.0\"?>\n<wayfire>\n" <<
+            "  <plugin name=\"" << plugin_name(i) << "\">\n" <<
+            "    <_short>Bench " << i << "</_short>\n" <<
+            "    <_long>Synthetic plugin " << i << "</_long>\n" <<
+            "    <category>" << (i % 2 ? "Utility" : "Effects") << "</category>\n";
+        for (int j = 0; j < options / 2; j++)
+        {
+            write_option(out, i, j);
+        }
+
+        out << "    <group>\n    <_short>Group</_short>\n";
+        bool in_subgroup = false;
+        for (int j = options / 2; j < options; j++)
+        {
+            if (!in_subgroup && (j >= options * 3 / 4))
+            {
+                out << "    <subgroup>\n    <_short>Subgroup</_short>\n";
+                in_subgroup = true;
+            }
+
+            write_option(out, i, j);
+        }
+
+        if (in_subgroup)
+        {
+            out << "    </subgroup>\n";
+        }
+
+        out << "    </group>\n  </plugin>\n</wayfire>\n";
+
+        config << "\n[" << plugin_name(i) << "]\n";
+        for (int j = 0; j < options; j += 2)
+        {
+            if (OPTION_TYPES[j % std::size(OPTION_TYPES)] == std::string("int"))
+            {
+                config << "option" << j << " = 2\n";
+            }
+        }
+    }
+}
+
+double elapsed_ms(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+}
+
+int main(int argc, char **argv)
+{
+    const int plugins = argc > 1 ? std::atoi(argv[1]) : 50;
+    const int options = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    char tmpl[] = "/tmp/wcm-bench-XXXXXX";
+    if (!mkdtemp(tmpl))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    const std::string tmpdir = tmpl;
+    const std::string xmldir = tmpdir + "/metadata";
+    const std::string ini    = tmpdir + "/wayfire.ini";
+    generate(xmldir, ini, plugins, options);
+    std::ofstream(tmpdir + "/defaults.ini");
+    setenv("XDG_CACHE_HOME", (tmpdir + "/cache").c_str(), 1);
+
+    // Gtk::Application and the widgets of WCM need a display, so check for
+    // one before creating anything
+    const bool have_display = gtk_init_check(nullptr, nullptr);
+
+    // wcm reports every plugin it loads, keep that out of the results
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    freopen("/dev/null", "w", stdout);
+
+    // Only the generated metadata is loaded, not the one installed on the
+    // system, so the results do not depend on the installed plugins
+    auto start  = bench_clock::now();
+    auto config = wf::config::build_configuration({xmldir}, tmpdir + "/defaults.ini", ini);
+    const double metadata_ms = elapsed_ms(start);
+
+    start = bench_clock::now();
+    auto loaded = Plugin::get_plugins_data(config);
+    for (auto *plugin : loaded)
+    {
+        plugin->load_options();
+    }
+
+    const double tree_ms = elapsed_ms(start);
+
+    double main_page_ms = -1;
+    double filter_ms    = -1;
+    if (have_display)
+    {
+        // The application is never registered, the WCM singleton is only
+        // needed to load the plugin icons
+        auto app = Gtk::Application::create("org.gtk.wcm.bench", Gio::APPLICATION_NON_UNIQUE);
+        WCM wcm(app);
+
+        start = bench_clock::now();
+        auto main_page = std::make_unique<MainPage>(loaded);
+        main_page_ms = elapsed_ms(start);
+
+        start = bench_clock::now();
+        main_page->set_filter("bench 1");
+        filter_ms = elapsed_ms(start);
+    }
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    printf("{\"plugins\": %d, \"options\": %d, \"loaded_plugins\": %zu, "
+           "\"metadata_parse_ms\": %.3f, \"plugin_tree_ms\": %.3f",
+        plugins, options, loaded.size(), metadata_ms, tree_ms);
+    if (have_display)
+    {
+        printf(", \"main_page_ms\": %.3f, \"first_filter_ms\": %.3f", main_page_ms, filter_ms);
+    }
+
+    printf("}\n");
+
+    std::error_code ec;
+    std::filesystem::remove_all(tmpdir, ec);
+    return 0;
+}
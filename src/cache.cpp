@@ -0,0 +1,528 @@
+#include "cache.hpp"
+#include "wcm.hpp"
+
+#include <algorithm>
+#include <clocale>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sys/stat.h>
+#include <unordered_map>
+
+namespace
+{
+constexpr char CACHE_MAGIC[4] = {'W', 'C', 'M', 'C'};
+constexpr uint32_t CACHE_VERSION = 2;
+
+/* The file holds the header, the key, a table of plugin headers, the option
+ * records of every plugin and the string table. All records are 8-byte
+ * aligned, so they can be read in place from the mapping. The cache is
+ * per-machine, so native byte order is used. */
+struct cache_string
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct cache_header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t key_size;
+    uint32_t plugin_count;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+};
+
+struct plugin_record
+{
+    cache_string name;
+    cache_string disp_name;
+    cache_string tooltip;
+    cache_string category;
+    uint32_t type;
+    uint32_t group_count;
+    uint64_t options_offset;
+};
+
+struct option_record
+{
+    cache_string name;
+    cache_string disp_name;
+    cache_string tooltip;
+    cache_string default_str;
+    uint32_t type;
+    uint32_t hidden;
+    uint32_t default_index;
+    int32_t default_int;
+    double default_double;
+    double min;
+    double max;
+    double precision;
+    uint32_t hints;
+    uint32_t int_label_count;
+    uint32_t str_label_count;
+    uint32_t child_count;
+};
+
+struct int_label_record
+{
+    cache_string name;
+    int32_t value;
+    uint32_t padding;
+};
+
+struct str_label_record
+{
+    cache_string name;
+    cache_string value;
+};
+
+size_t align8(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+std::string build_key(const std::vector<std::string> & xmldirs)
+{
+    std::string key;
+    auto append_raw = [&key] (const void *data, size_t size)
+    {
+        key.append((const char*)data, size);
+    };
+    auto append_str = [&] (const std::string & str)
+    {
+        uint32_t length = str.length();
+        append_raw(&length, sizeof(length));
+        key += str;
+    };
+
+    // Option names and descriptions are stored translated
+    const char *locale   = setlocale(LC_MESSAGES, nullptr);
+    const char *language = std::getenv("LANGUAGE");
+    append_str(locale ? locale : "");
+    append_str(language ? language : "");
+
+    for (const auto & dir : xmldirs)
+    {
+        append_str(dir);
+
+        std::vector<std::string> files;
+        std::error_code ec;
+        for (const auto & entry : std::filesystem::directory_iterator(dir, ec))
+        {
+            if (entry.path().extension() == ".xml")
+            {
+                files.push_back(entry.path());
+            }
+        }
+
+        std::sort(files.begin(), files.end());
+        for (const auto & file : files)
+        {
+            struct stat st;
+            if (stat(file.c_str(), &st) != 0)
+            {
+                continue;
+            }
+
+            int64_t mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+            int64_t size  = st.st_size;
+            append_str(file);
+            append_raw(&mtime, sizeof(mtime));
+            append_raw(&size, sizeof(size));
+        }
+    }
+
+    return key;
+}
+
+class cache_writer
+{
+  public:
+    std::string records;
+    std::string strings;
+
+    template<class T>
+    void append(const T & record)
+    {
+        records.append((const char*)&record, sizeof(T));
+    }
+
+    cache_string add_string(const std::string & str)
+    {
+        auto it = offsets.find(str);
+        if (it != offsets.end())
+        {
+            return it->second;
+        }
+
+        cache_string result = {(uint32_t)strings.size(), (uint32_t)str.length()};
+        strings += str;
+        strings += '\0';
+        offsets.emplace(str, result);
+        return result;
+    }
+
+    void add_option(const Option *option)
+    {
+        option_record record = {};
+        record.name      = add_string(option->name);
+        record.disp_name = add_string(option->disp_name);
+        record.tooltip   = add_string(option->tooltip);
+        record.type   = option->type();
+        record.hidden = option->hidden();
+        record.default_index = option->store->default_kinds[option->id];
+        switch (record.default_index)
+        {
+          case OptionStore::DEFAULT_INT:
+            record.default_int = option->default_int();
+            break;
+
+          case OptionStore::DEFAULT_STRING:
+            record.default_str = add_string(option->default_string());
+            break;
+
+          default:
+            record.default_double = option->default_double();
+            break;
+        }
+
+        const var_data & data = option->get_data();
+        record.min = data.min;
+        record.max = data.max;
+        record.precision = data.precision;
+        record.hints     = data.hints;
+        record.int_label_count = option->int_labels().size();
+        record.str_label_count = option->str_labels().size();
+        record.child_count     = option->options.size();
+        append(record);
+
+        for (const auto & [name, value] : option->int_labels())
+        {
+            append(int_label_record{add_string(name), value, 0});
+        }
+
+        for (const auto & [name, value] : option->str_labels())
+        {
+            append(str_label_record{add_string(name), add_string(value)});
+        }
+
+        for (const auto *child : option->options)
+        {
+            add_option(child);
+        }
+    }
+
+  private:
+    std::unordered_map<std::string, cache_string> offsets;
+};
+
+class cache_reader
+{
+  public:
+    cache_reader(const char *begin, const char *end, const char *strings, size_t strings_size) :
+        pos(begin), end(end), strings(strings), strings_size(strings_size)
+    {}
+
+    bool valid = true;
+
+    template<class T>
+    const T *next()
+    {
+        if ((size_t)(end - pos) < sizeof(T))
+        {
+            valid = false;
+            return nullptr;
+        }
+
+        const T *record = (const T*)pos;
+        pos += sizeof(T);
+        return record;
+    }
+
+    std::string get_string(const cache_string & str)
+    {
+        if (((uint64_t)str.offset + str.length) > strings_size)
+        {
+            valid = false;
+            return "";
+        }
+
+        return std::string(strings + str.offset, str.length);
+    }
+
+    Option *read_option(Plugin *plugin, Option *parent)
+    {
+        const option_record *record = next<option_record>();
+        if (!record)
+        {
+            return nullptr;
+        }
+
+        Option *option = plugin->option_store.create(plugin, (option_type)record->type);
+        option->parent    = parent;
+        option->name      = get_string(record->name);
+        option->disp_name = get_string(record->disp_name);
+        option->tooltip   = get_string(record->tooltip);
+        option->set_hidden(record->hidden);
+        switch (record->default_index)
+        {
+          case OptionStore::DEFAULT_INT:
+            option->set_default((int)record->default_int);
+            break;
+
+          case OptionStore::DEFAULT_STRING:
+            option->set_default(get_string(record->default_str));
+            break;
+
+          default:
+            option->set_default(record->default_double);
+            break;
+        }
+
+        if (record->min || record->max || record->precision || record->hints)
+        {
+            var_data & data = option->edit_data();
+            data.min = record->min;
+            data.max = record->max;
+            data.precision = record->precision;
+            data.hints     = (hint_type)record->hints;
+        }
+
+        for (uint32_t i = 0; valid && i < record->int_label_count; i++)
+        {
+            if (auto label = next<int_label_record>())
+            {
+                option->add_int_label(get_string(label->name), label->value);
+            }
+        }
+
+        for (uint32_t i = 0; valid && i < record->str_label_count; i++)
+        {
+            if (auto label = next<str_label_record>())
+            {
+                option->add_str_label(get_string(label->name), get_string(label->value));
+            }
+        }
+
+        for (uint32_t i = 0; valid && i < record->child_count; i++)
+        {
+            if (Option *child = read_option(plugin, option))
+            {
+                option->options.push_back(child);
+            }
+        }
+
+        return option;
+    }
+
+  private:
+    const char *pos;
+    const char *end;
+    const char *strings;
+    size_t strings_size;
+};
+}
+
+struct MetadataCache::builder
+{
+    // the plugin records, and the option records and strings of all plugins
+    cache_writer headers;
+    cache_writer writer;
+    uint32_t plugin_count = 0;
+};
+
+MetadataCache::MetadataCache() = default;
+MetadataCache::~MetadataCache() = default;
+MetadataCache::MetadataCache(MetadataCache &&) = default;
+MetadataCache& MetadataCache::operator =(MetadataCache &&) = default;
+
+MetadataCache::MetadataCache(const std::vector<std::string> & xmldirs)
+{
+    path = get_xdg_dir("XDG_CACHE_HOME", ".cache") + "/wcm/metadata.cache";
+    key  = build_key(xmldirs);
+}
+
+bool MetadataCache::load(std::vector<Plugin*> & plugins)
+{
+    if (path.empty())
+    {
+        return false;
+    }
+
+    mapping = MappedFile(path);
+    if (!mapping || (mapping.size() < sizeof(cache_header)))
+    {
+        return false;
+    }
+
+    const char *begin = mapping.data();
+    const cache_header *header = (const cache_header*)begin;
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) ||
+        (header->version != CACHE_VERSION) ||
+        (header->key_size != key.size()) ||
+        (mapping.size() < sizeof(cache_header) + key.size()) ||
+        memcmp(begin + sizeof(cache_header), key.data(), key.size()) ||
+        (header->strings_offset < align8(sizeof(cache_header) + key.size())) ||
+        (header->strings_offset > mapping.size()) ||
+        (header->strings_size > mapping.size() - header->strings_offset))
+    {
+        mapping = MappedFile();
+        return false;
+    }
+
+    const char *records = begin + align8(sizeof(cache_header) + key.size());
+    cache_reader reader{records, begin + header->strings_offset,
+        begin + header->strings_offset, header->strings_size};
+
+    // Only the plugin headers are read here, see load_options()
+    std::vector<Plugin*> result;
+    for (uint32_t i = 0; reader.valid && i < header->plugin_count; i++)
+    {
+        const plugin_record *record = reader.next<plugin_record>();
+        if (!record)
+        {
+            break;
+        }
+
+        Plugin *plugin = new Plugin();
+        plugin->name      = reader.get_string(record->name);
+        plugin->disp_name = reader.get_string(record->disp_name);
+        plugin->tooltip   = reader.get_string(record->tooltip);
+        plugin->category  = reader.get_string(record->category);
+        plugin->type  = (plugin_type)record->type;
+        plugin->cache = this;
+        plugin->cache_offset = (const char*)record - begin;
+        result.push_back(plugin);
+
+        if ((record->options_offset < (uint64_t)(records - begin)) ||
+            (record->options_offset > header->strings_offset))
+        {
+            reader.valid = false;
+        }
+    }
+
+    if (!reader.valid)
+    {
+        std::cerr << "Ignoring corrupted metadata cache " << path << std::endl;
+        for (auto *plugin : result)
+        {
+            delete plugin;
+        }
+
+        mapping = MappedFile();
+        return false;
+    }
+
+    plugins.insert(plugins.end(), result.begin(), result.end());
+    return true;
+}
+
+void MetadataCache::load_options(Plugin *plugin) const
+{
+    const char *begin = mapping.data();
+    const cache_header *header = (const cache_header*)begin;
+    const plugin_record *record = (const plugin_record*)(begin + plugin->cache_offset);
+    cache_reader reader{begin + record->options_offset, begin + header->strings_offset,
+        begin + header->strings_offset, header->strings_size};
+
+    for (uint32_t i = 0; reader.valid && i < record->group_count; i++)
+    {
+        if (Option *group = reader.read_option(plugin, nullptr))
+        {
+            plugin->option_groups.push_back(group);
+        }
+    }
+
+    if (!reader.valid)
+    {
+        std::cerr << "Corrupted metadata cache entry for plugin " << plugin->name << std::endl;
+    }
+}
+
+void MetadataCache::add(const Plugin *plugin)
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    if (!pending)
+    {
+        pending = std::make_unique<builder>();
+    }
+
+    // Parse the options again even if the plugin has them loaded: once its
+    // page was opened, its dynamic lists hold children made from the config
+    // (autostart commands, command bindings), which are no metadata.
+    Plugin parsed;
+    parsed.name     = plugin->name;
+    parsed.xml_node = plugin->xml_node;
+    parsed.cache    = plugin->cache;
+    parsed.cache_offset = plugin->cache_offset;
+    parsed.load_options();
+    const auto & groups = parsed.option_groups;
+
+    // options_offset is relative to the option records until store()
+    plugin_record record = {};
+    record.name      = pending->writer.add_string(plugin->name);
+    record.disp_name = pending->writer.add_string(plugin->disp_name);
+    record.tooltip   = pending->writer.add_string(plugin->tooltip);
+    record.category  = pending->writer.add_string(plugin->category);
+    record.type = plugin->type;
+    record.group_count    = groups.size();
+    record.options_offset = pending->writer.records.size();
+    pending->headers.append(record);
+    pending->plugin_count++;
+    for (const auto *group : groups)
+    {
+        pending->writer.add_option(group);
+    }
+}
+
+void MetadataCache::store()
+{
+    if (!pending)
+    {
+        return;
+    }
+
+    auto built = std::move(pending);
+    size_t records_offset = align8(sizeof(cache_header) + key.size());
+    size_t options_offset = records_offset + built->headers.records.size();
+
+    // The plugin headers go into a table of their own, followed by the
+    // options of all plugins
+    for (uint32_t i = 0; i < built->plugin_count; i++)
+    {
+        char *ptr = built->headers.records.data() + i * sizeof(plugin_record);
+        plugin_record record;
+        memcpy(&record, ptr, sizeof(record));
+        record.options_offset += options_offset;
+        memcpy(ptr, &record, sizeof(record));
+    }
+
+    const cache_writer & writer = built->writer;
+    cache_header header = {};
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.key_size     = key.size();
+    header.plugin_count = built->plugin_count;
+    header.strings_offset = options_offset + writer.records.size();
+    header.strings_size   = writer.strings.size();
+
+    std::string contents;
+    contents.reserve(header.strings_offset + header.strings_size);
+    contents.append((const char*)&header, sizeof(header));
+    contents += key;
+    contents.resize(records_offset, '\0');
+    contents += built->headers.records;
+    contents += writer.records;
+    contents += writer.strings;
+
+    if (!write_file_atomic(path, contents))
+    {
+        std::cerr << "Failed to write metadata cache " << path << std::endl;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+class Plugin;
+
+/*!
+ * Binary cache of the plugin metadata parsed from the XML files.
+ *
+ * The cache lives in `$XDG_CACHE_HOME/wcm/metadata.cache` and is keyed by the
+ * path, mtime and size of every XML file in the metadata directories, so it is
+ * rebuilt automatically whenever one of them changes. A valid cache is mapped
+ * into memory and the plugin tree is read directly from the mapping.
+ */
+class MetadataCache
+{
+  public:
+    MetadataCache();
+    explicit MetadataCache(const std::vector<std::string> & xmldirs);
+    ~MetadataCache();
+    MetadataCache(MetadataCache &&);
+    MetadataCache& operator =(MetadataCache &&);
+
+    /*!
+     * Load the plugin headers from the cache. Returns `false` if the cache is
+     * missing or stale, in which case `plugins` is left untouched.
+     */
+    bool load(std::vector<Plugin*> & plugins);
+
+    /*!
+     * Build the option tree of a plugin returned by load().
+     */
+    void load_options(Plugin *plugin) const;
+
+    /*!
+     * Add `plugin` to the cache written by store(). Its options are parsed
+     * into a temporary tree which is freed right away, so building the cache
+     * does not keep the options of every plugin in memory, and the values a
+     * loaded plugin took from the config stay out of the cache.
+     */
+    void add(const Plugin *plugin);
+    /*!
+     * Write the plugins given to add() to the cache file.
+     */
+    void store();
+
+  private:
+    struct builder;
+
+    std::string path;
+    std::string key;
+    MappedFile mapping;
+    // plugins added since the last store()
+    std::unique_ptr<builder> pending;
+};
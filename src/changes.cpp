@@ -0,0 +1,440 @@
+#include "changes.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <unistd.h>
+
+namespace
+{
+/* Fields are separated by tabs, so tabs, newlines and backslashes in them
+ * are escaped */
+std::string escape(const std::string & field)
+{
+    std::string result;
+    result.reserve(field.size());
+    for (char c : field)
+    {
+        switch (c)
+        {
+          case '\\':
+            result += "\\\\";
+            break;
+
+          case '\t':
+            result += "\\t";
+            break;
+
+          case '\n':
+            result += "\\n";
+            break;
+
+          default:
+            result += c;
+        }
+    }
+
+    return result;
+}
+
+/* Split a line of the log into its fields and undo escape() */
+std::vector<std::string> split_fields(const std::string & line)
+{
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < line.size(); i++)
+    {
+        if (line[i] == '\t')
+        {
+            fields.emplace_back();
+        } else if ((line[i] == '\\') && (i + 1 < line.size()))
+        {
+            const char c = line[++i];
+            fields.back() += (c == 't') ? '\t' : (c == 'n') ? '\n' : c;
+        } else
+        {
+            fields.back() += line[i];
+        }
+    }
+
+    return fields;
+}
+
+/* Start of a "disk" or "written" line, with the hash of `file` in hex */
+std::string hash_line(const char *kind, const std::string & file, uint64_t hash)
+{
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+    return std::string(kind) + "\t" + escape(file) + "\t" + hex;
+}
+}
+
+void ConfigChange::apply() const
+{
+    switch (kind)
+    {
+      case SET_VALUE:
+        option->set_value_str(new_value);
+        break;
+
+      case REGISTER:
+        section->register_new_option(option);
+        break;
+
+      case UNREGISTER:
+        section->unregister_option(option);
+        break;
+    }
+}
+
+void ConfigChange::revert() const
+{
+    switch (kind)
+    {
+      case SET_VALUE:
+        option->set_value_str(old_value);
+        break;
+
+      case REGISTER:
+        section->unregister_option(option);
+        break;
+
+      case UNREGISTER:
+        section->register_new_option(option);
+        break;
+    }
+}
+
+void ChangeJournal::record(std::vector<ConfigChange> changes)
+{
+    if (changes.empty())
+    {
+        return;
+    }
+
+    history.erase(history.begin() + position, history.end());
+    if (history.size() == MAX_HISTORY)
+    {
+        history.pop_front();
+    }
+
+    history.push_back(std::move(changes));
+    position = history.size();
+}
+
+const std::vector<ConfigChange> *ChangeJournal::undo()
+{
+    if (position == 0)
+    {
+        return nullptr;
+    }
+
+    const auto & changes = history[--position];
+    for (auto it = changes.rbegin(); it != changes.rend(); ++it)
+    {
+        it->revert();
+    }
+
+    return &changes;
+}
+
+const std::vector<ConfigChange> *ChangeJournal::redo()
+{
+    if (position == history.size())
+    {
+        return nullptr;
+    }
+
+    const auto & changes = history[position++];
+    for (const auto & change : changes)
+    {
+        change.apply();
+    }
+
+    return &changes;
+}
+
+void ChangeJournal::forget(const std::set<std::pair<std::string, std::string>> & options)
+{
+    auto touches = [&options] (const std::vector<ConfigChange> & changes)
+    {
+        return std::any_of(changes.begin(), changes.end(), [&options] (const ConfigChange & change)
+        {
+            const auto & section = change.section->get_name();
+            return options.count({section, change.option->get_name()}) ||
+                   options.count({section, ""});
+        });
+    };
+
+    // the transactions before `position` can be undone, keep it between them
+    // and those which can be redone
+    size_t kept = 0;
+    const size_t applied = position;
+    for (size_t i = 0; i < history.size(); i++)
+    {
+        if (touches(history[i]))
+        {
+            if (i < applied)
+            {
+                position--;
+            }
+
+            continue;
+        }
+
+        if (kept != i)
+        {
+            history[kept] = std::move(history[i]);
+        }
+
+        kept++;
+    }
+
+    history.resize(kept);
+}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    close();
+}
+
+uint64_t WriteAheadLog::hash(const std::string & contents)
+{
+    // FNV-1a
+    uint64_t result = 14695981039346656037ull;
+    for (unsigned char c : contents)
+    {
+        result ^= c;
+        result *= 1099511628211ull;
+    }
+
+    return result;
+}
+
+WriteAheadLog::replay WriteAheadLog::open(const std::string & path)
+{
+    close();
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return {};
+    }
+
+    std::string contents;
+    char buf[4096];
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) != 0)
+    {
+        if (len > 0)
+        {
+            contents.append(buf, len);
+        } else if (errno != EINTR)
+        {
+            break;
+        }
+    }
+
+    replay result;
+    std::vector<record> batch;
+    // batch of each record in result.records
+    std::vector<uint64_t> record_batches;
+    // end of the last complete transaction, a crash may have cut off the rest
+    size_t end = 0;
+    size_t pos = 0;
+    for (size_t eol; (eol = contents.find('\n', pos)) != std::string::npos; pos = eol + 1)
+    {
+        auto fields = split_fields(contents.substr(pos, eol - pos));
+        if ((fields[0] == "set") && (fields.size() == 5))
+        {
+            batch.push_back({fields[1], fields[2], fields[3], fields[4]});
+        } else if ((fields[0] == "unregister") && (fields.size() == 4))
+        {
+            batch.push_back({fields[1], fields[2], fields[3], std::nullopt});
+        } else if ((fields[0] == "commit") && (fields.size() == 2))
+        {
+            const uint64_t number = std::strtoull(fields[1].c_str(), nullptr, 10);
+            result.last_batch = std::max(result.last_batch, number);
+            record_batches.insert(record_batches.end(), batch.size(), number);
+            std::move(batch.begin(), batch.end(), std::back_inserter(result.records));
+            batch.clear();
+        } else if (((fields[0] == "disk") && (fields.size() == 3)) ||
+                   ((fields[0] == "written") && (fields.size() == 4)))
+        {
+            const auto & file = fields[1];
+            const uint64_t hash = std::strtoull(fields[2].c_str(), nullptr, 16);
+            // the records of the batches up to this one are in the file, or
+            // the file was changed by someone else after them
+            uint64_t last_batch = UINT64_MAX;
+            if (fields[0] == "written")
+            {
+                last_batch = std::strtoull(fields[3].c_str(), nullptr, 10);
+            } else if (!result.hashes.count(file) || (result.hashes[file] == hash))
+            {
+                last_batch = 0;
+            }
+
+            size_t kept = 0;
+            for (size_t i = 0; i < result.records.size(); i++)
+            {
+                if ((result.records[i].file == file) && (record_batches[i] <= last_batch))
+                {
+                    continue;
+                }
+
+                if (kept != i)
+                {
+                    result.records[kept] = std::move(result.records[i]);
+                    record_batches[kept] = record_batches[i];
+                }
+
+                kept++;
+            }
+
+            result.records.resize(kept);
+            record_batches.resize(kept);
+            result.hashes[file] = logged[file] = hash;
+        }
+
+        if (batch.empty())
+        {
+            end = eol + 1;
+        }
+    }
+
+    size = contents.size();
+    if ((end < contents.size()) && (ftruncate(fd, end) == 0))
+    {
+        size = end;
+    }
+
+    return result;
+}
+
+bool WriteAheadLog::write_all(const std::string & text)
+{
+    const char *buf = text.data();
+    size_t left     = text.size();
+    while (left > 0)
+    {
+        ssize_t written = write(fd, buf, left);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            std::cerr << "Failed to log changes: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        buf  += written;
+        left -= written;
+        size += written;
+    }
+
+    return true;
+}
+
+bool WriteAheadLog::append(uint64_t batch, const std::vector<record> & records,
+    const std::unordered_map<std::string, uint64_t> & hashes)
+{
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    std::string text;
+    for (const auto & [file, hash] : hashes)
+    {
+        auto it = logged.find(file);
+        if ((it == logged.end()) || (it->second != hash))
+        {
+            text += hash_line("disk", file, hash) + "\n";
+            logged[file] = hash;
+        }
+    }
+
+    for (const auto & rec : records)
+    {
+        text += (rec.value ? "set\t" : "unregister\t") + escape(rec.file) + "\t" +
+            escape(rec.section) + "\t" + escape(rec.option);
+        if (rec.value)
+        {
+            text += "\t" + escape(*rec.value);
+        }
+
+        text += '\n';
+    }
+
+    text += "commit\t" + std::to_string(batch) + "\n";
+    if (!write_all(text))
+    {
+        return false;
+    }
+
+    if (fdatasync(fd) != 0)
+    {
+        std::cerr << "Failed to sync the change log: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void WriteAheadLog::loaded(const std::string & file, uint64_t hash)
+{
+    // an empty log has nothing to replay, the next append() logs the hash
+    if ((fd < 0) || (size == 0))
+    {
+        return;
+    }
+
+    auto it = logged.find(file);
+    if ((it == logged.end()) || (it->second != hash))
+    {
+        write_all(hash_line("disk", file, hash) + "\n");
+        logged[file] = hash;
+    }
+}
+
+void WriteAheadLog::written(const std::string & file, uint64_t hash, uint64_t last_batch)
+{
+    if ((fd >= 0) && (size > 0))
+    {
+        write_all(hash_line("written", file, hash) + "\t" + std::to_string(last_batch) + "\n");
+        logged[file] = hash;
+    }
+}
+
+void WriteAheadLog::clear()
+{
+    if ((fd >= 0) && (size > 0))
+    {
+        if (ftruncate(fd, 0) == 0)
+        {
+            fsync(fd);
+            size = 0;
+            logged.clear();
+        }
+    }
+}
+
+void WriteAheadLog::close()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd   = -1;
+        size = 0;
+        logged.clear();
+    }
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <wayfire/config/section.hpp>
+
+/*!
+ * A single change of a config section, with what is needed to undo it.
+ */
+struct ConfigChange
+{
+    enum kind_t
+    {
+        SET_VALUE,
+        REGISTER,
+        UNREGISTER,
+    };
+
+    kind_t kind;
+    std::shared_ptr<wf::config::section_t> section;
+    std::shared_ptr<wf::config::option_base_t> option;
+    // only used by SET_VALUE
+    std::string old_value;
+    std::string new_value;
+
+    void apply() const;
+    void revert() const;
+};
+
+/*!
+ * History of the committed transactions, for undo and redo. Each entry holds
+ * the changes of one transaction, so undoing or redoing one is proportional
+ * to the size of that transaction only, and never touches the config files.
+ * Recovering unsaved changes after a crash is left to the WriteAheadLog.
+ */
+class ChangeJournal
+{
+  public:
+    static constexpr size_t MAX_HISTORY = 1000;
+
+    /*!
+     * Append the changes of a committed transaction. Drops the transactions
+     * which were undone, they can no longer be redone.
+     */
+    void record(std::vector<ConfigChange> changes);
+    /*!
+     * Revert the last transaction and return its changes, or nullptr if
+     * there is nothing to undo.
+     */
+    const std::vector<ConfigChange> *undo();
+    /*!
+     * Apply the last undone transaction again and return its changes, or
+     * nullptr if there is nothing to redo.
+     */
+    const std::vector<ConfigChange> *redo();
+    /*!
+     * Drop the transactions which changed any of `options`, given as section
+     * and option names. An empty option name stands for the whole section.
+     * Undoing or redoing them after the options were changed outside of WCM
+     * would overwrite that change.
+     */
+    void forget(const std::set<std::pair<std::string, std::string>> & options);
+
+  private:
+    std::deque<std::vector<ConfigChange>> history;
+    // history[position] is the next transaction to redo
+    size_t position = 0;
+};
+
+/*!
+ * Log of the changes which may not have reached the config files yet, so
+ * they can be restored after a crash. Each record holds the state of one
+ * option after a change, its value or that it was removed. The records of a
+ * transaction are appended as one batch ending with a commit marker, and
+ * synced to disk together.
+ *
+ * Batches are numbered. The log also holds a hash of each config file: of
+ * the contents the batches apply to, and of the contents of each write along
+ * with the last batch it holds. A file loaded with another hash was changed
+ * by someone else, which drops its earlier records, and a file whose hash no
+ * longer matches the log should not be replayed either.
+ *
+ * Not thread-safe, the ConfigWriter uses it from its thread.
+ */
+class WriteAheadLog
+{
+  public:
+    struct record
+    {
+        std::string file;
+        std::string section;
+        std::string option;
+        // empty if the option was removed
+        std::optional<std::string> value;
+    };
+
+    /*!
+     * What a previous run left in the log.
+     */
+    struct replay
+    {
+        // committed records not known to be in their file, in order
+        std::vector<record> records;
+        // last hash logged for each file
+        std::unordered_map<std::string, uint64_t> hashes;
+        // number of the last batch in the log
+        uint64_t last_batch = 0;
+    };
+
+    WriteAheadLog() = default;
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog& operator =(const WriteAheadLog &) = delete;
+
+    static uint64_t hash(const std::string & contents);
+
+    /*!
+     * Open the log at `path`, creating it if needed, and return the records
+     * left by a previous run which did not finish writing its changes. A
+     * transaction cut off by a crash is dropped.
+     */
+    replay open(const std::string & path);
+
+    inline bool is_open() const
+    {
+        return fd >= 0;
+    }
+
+    /*!
+     * Append the records of one transaction as batch number `batch` and wait
+     * until they are on disk. `hashes` holds the contents on disk of the files
+     * they touch, if known. Returns false if the log is not open or the append
+     * failed.
+     */
+    bool append(uint64_t batch, const std::vector<record> & records,
+        const std::unordered_map<std::string, uint64_t> & hashes);
+    /*!
+     * Note the contents `file` now has on disk, after it was loaded. Not
+     * synced, the next append() syncs it along.
+     */
+    void loaded(const std::string & file, uint64_t hash);
+    /*!
+     * Note that we wrote `file`, and that it holds its records of every batch
+     * up to `last_batch`. Not synced either.
+     */
+    void written(const std::string & file, uint64_t hash, uint64_t last_batch);
+    /*!
+     * Drop all records, once every change is written to its config file.
+     */
+    void clear();
+    void close();
+
+  private:
+    bool write_all(const std::string & text);
+
+    int fd = -1;
+    size_t size = 0;
+    // hash of each file logged since the log was last cleared
+    std::unordered_map<std::string, uint64_t> logged;
+};
@@ -0,0 +1,318 @@
+#include "icons.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace
+{
+constexpr char ICON_CACHE_MAGIC[4] = {'W', 'C', 'M', 'I'};
+constexpr uint32_t ICON_CACHE_VERSION = 1;
+
+/* The icon cache holds the header, a table of entries, the icon paths and
+ * the pixel data, which is 8-byte aligned and stored as gdk-pixbuf lays it
+ * out in memory. */
+struct icon_cache_header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t padding;
+};
+
+struct icon_cache_entry
+{
+    int64_t mtime;
+    uint64_t data_offset;
+    uint64_t data_length;
+    uint32_t path_offset;
+    uint32_t path_length;
+    uint32_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowstride;
+    uint32_t has_alpha;
+    uint32_t padding;
+};
+
+int64_t get_mtime(const std::string & path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        return -1;
+    }
+
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+}
+
+IconIndex::IconIndex()
+{
+    auto user_data_dir = get_xdg_dir("XDG_DATA_HOME", ".local/share");
+    if (!user_data_dir.empty())
+    {
+        directories.push_back({user_data_dir + "/wayfire/icons"});
+    }
+
+    directories.push_back({WAYFIRE_ICONDIR});
+    directories.push_back({WCM_ICONDIR});
+}
+
+void IconIndex::revalidate()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (validated && (now - last_validated < REVALIDATE_INTERVAL))
+    {
+        return;
+    }
+
+    validated = true;
+    last_validated = now;
+    for (auto & dir : directories)
+    {
+        struct stat st;
+        struct timespec mtime = {-1, -1};
+        if (stat(dir.path.c_str(), &st) == 0)
+        {
+            mtime = st.st_mtim;
+        }
+
+        if ((mtime.tv_sec == dir.mtime.tv_sec) && (mtime.tv_nsec == dir.mtime.tv_nsec))
+        {
+            continue;
+        }
+
+        dir.mtime = mtime;
+        dir.names.clear();
+        std::error_code ec;
+        for (const auto & entry : std::filesystem::directory_iterator(dir.path, ec))
+        {
+            dir.names.insert(entry.path().filename());
+        }
+    }
+}
+
+std::string IconIndex::find(const std::string & name)
+{
+    revalidate();
+    for (const auto & dir : directories)
+    {
+        if (dir.names.count(name))
+        {
+            return dir.path + "/" + name;
+        }
+    }
+
+    return "";
+}
+
+IconLoader::IconLoader()
+{
+    dispatcher.connect(sigc::mem_fun(*this, &IconLoader::dispatch));
+}
+
+IconLoader::~IconLoader()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        cond.notify_one();
+        worker.join();
+    }
+}
+
+void IconLoader::load(const std::string & path, int size, const slot_loaded & callback)
+{
+    uint64_t id = next_id++;
+    callbacks.emplace(id, callback);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({id, path, size, {}});
+    }
+
+    if (!worker.joinable())
+    {
+        worker = std::thread(&IconLoader::run, this);
+    }
+
+    cond.notify_one();
+}
+
+void IconLoader::run()
+{
+    open_cache();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        auto has_work = [this] { return stopping || !pending.empty(); };
+        if (!cache_dirty)
+        {
+            cond.wait(lock, has_work);
+        } else if (!cond.wait_for(lock, CACHE_WRITE_DELAY, has_work) || stopping)
+        {
+            // Icons are requested in bursts, write once the burst is over
+            lock.unlock();
+            write_cache();
+            lock.lock();
+            continue;
+        }
+
+        if (stopping)
+        {
+            return;
+        }
+
+        request req = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+
+        const int64_t mtime = get_mtime(req.path);
+        auto it = cache.find({req.path, req.size});
+        if ((it != cache.end()) && (it->second.mtime == mtime))
+        {
+            req.pixbuf = it->second.pixbuf;
+        } else
+        {
+            try {
+                req.pixbuf = Gdk::Pixbuf::create_from_file(req.path, req.size, req.size, true);
+                cache[{req.path, req.size}] = {mtime, req.pixbuf};
+                cache_dirty = true;
+            } catch (const Glib::Error & e)
+            {
+                std::cerr << "Failed to load icon " << req.path << ": " << e.what() << std::endl;
+            }
+        }
+
+        lock.lock();
+        finished.push_back(std::move(req));
+        dispatcher.emit();
+    }
+}
+
+void IconLoader::open_cache()
+{
+    cache_path    = get_xdg_dir("XDG_CACHE_HOME", ".cache") + "/wcm/icons.cache";
+    cache_mapping = MappedFile(cache_path);
+    if (!cache_mapping || (cache_mapping.size() < sizeof(icon_cache_header)))
+    {
+        return;
+    }
+
+    const char *begin = cache_mapping.data();
+    const size_t size = cache_mapping.size();
+    const icon_cache_header *header = (const icon_cache_header*)begin;
+    if (memcmp(header->magic, ICON_CACHE_MAGIC, sizeof(ICON_CACHE_MAGIC)) ||
+        (header->version != ICON_CACHE_VERSION) ||
+        (header->entry_count > (size - sizeof(icon_cache_header)) / sizeof(icon_cache_entry)))
+    {
+        return;
+    }
+
+    const icon_cache_entry *entries = (const icon_cache_entry*)(begin + sizeof(icon_cache_header));
+    for (uint32_t i = 0; i < header->entry_count; i++)
+    {
+        const auto & entry = entries[i];
+        const int channels = entry.has_alpha ? 4 : 3;
+        if (((uint64_t)entry.path_offset + entry.path_length > size) ||
+            (entry.data_offset > size) || (entry.data_length > size - entry.data_offset) ||
+            (entry.width == 0) || (entry.height == 0) ||
+            (entry.rowstride < entry.width * channels) ||
+            ((uint64_t)entry.rowstride * (entry.height - 1) + entry.width * channels > entry.data_length))
+        {
+            continue;
+        }
+
+        // The pixels are used in place, the mapping outlives the pixbufs
+        auto pixbuf = Gdk::Pixbuf::create_from_data((const guint8*)begin + entry.data_offset,
+            Gdk::COLORSPACE_RGB, entry.has_alpha, 8, entry.width, entry.height, entry.rowstride);
+        cache[{std::string(begin + entry.path_offset, entry.path_length), (int)entry.size}] =
+        {entry.mtime, pixbuf};
+    }
+}
+
+void IconLoader::write_cache()
+{
+    cache_dirty = false;
+
+    std::string paths;
+    std::string pixels;
+    std::vector<icon_cache_entry> entries;
+    for (const auto & [key, value] : cache)
+    {
+        const auto & pixbuf = value.pixbuf;
+        icon_cache_entry entry = {};
+        entry.mtime = value.mtime;
+        entry.data_offset = pixels.size();
+        entry.data_length = pixbuf->get_byte_length();
+        entry.path_offset = paths.size();
+        entry.path_length = key.path.length();
+        entry.size   = key.size;
+        entry.width  = pixbuf->get_width();
+        entry.height = pixbuf->get_height();
+        entry.rowstride = pixbuf->get_rowstride();
+        entry.has_alpha = pixbuf->get_has_alpha();
+        entries.push_back(entry);
+
+        paths  += key.path;
+        pixels += std::string((const char*)pixbuf->get_pixels(), entry.data_length);
+        pixels.resize((pixels.size() + 7) & ~(size_t)7, '\0');
+    }
+
+    const size_t entries_size = entries.size() * sizeof(icon_cache_entry);
+    const size_t paths_offset = sizeof(icon_cache_header) + entries_size;
+    const size_t data_offset  = (paths_offset + paths.size() + 7) & ~(size_t)7;
+    for (auto & entry : entries)
+    {
+        entry.path_offset += paths_offset;
+        entry.data_offset += data_offset;
+    }
+
+    icon_cache_header header = {};
+    memcpy(header.magic, ICON_CACHE_MAGIC, sizeof(ICON_CACHE_MAGIC));
+    header.version     = ICON_CACHE_VERSION;
+    header.entry_count = entries.size();
+
+    std::string contents;
+    contents.reserve(data_offset + pixels.size());
+    contents.append((const char*)&header, sizeof(header));
+    contents.append((const char*)entries.data(), entries_size);
+    contents += paths;
+    contents.resize(data_offset, '\0');
+    contents += pixels;
+
+    if (!write_file_atomic(cache_path, contents))
+    {
+        std::cerr << "Failed to write icon cache " << cache_path << std::endl;
+    }
+}
+
+void IconLoader::dispatch()
+{
+    std::vector<request> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(ready, finished);
+    }
+
+    for (auto & req : ready)
+    {
+        auto it = callbacks.find(req.id);
+        if (it == callbacks.end())
+        {
+            continue;
+        }
+
+        auto callback = std::move(it->second);
+        callbacks.erase(it);
+        if (req.pixbuf)
+        {
+            callback(req.pixbuf);
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <gtkmm.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/stat.h>
+
+#include "utils.hpp"
+
+/*!
+ * In-memory index of the icon files in the user's icon directory,
+ * WAYFIRE_ICONDIR and WCM_ICONDIR, in that order of priority.
+ *
+ * Each directory is scanned once. Its mtime is checked at most every
+ * REVALIDATE_INTERVAL, and the directory is rescanned when it has changed,
+ * so lookups normally touch no files at all.
+ */
+class IconIndex
+{
+  public:
+    static constexpr std::chrono::seconds REVALIDATE_INTERVAL{2};
+
+    IconIndex();
+
+    /*!
+     * Returns the full path of the icon `name`, or an empty string if none of
+     * the directories contains it.
+     */
+    std::string find(const std::string & name);
+
+  private:
+    struct directory
+    {
+        std::string path;
+        struct timespec mtime = {-1, -1};
+        std::unordered_set<std::string> names;
+    };
+
+    void revalidate();
+
+    std::vector<directory> directories;
+    std::chrono::steady_clock::time_point last_validated;
+    bool validated = false;
+};
+
+/*!
+ * Decodes icon files to pixbufs on a background thread, so that rendering
+ * SVGs does not block the main loop.
+ *
+ * Decoded pixbufs are kept in `$XDG_CACHE_HOME/wcm/icons.cache`, a single
+ * packed file keyed by icon path, mtime and pixel size, so that warm starts
+ * map that file instead of rasterizing the SVGs again.
+ */
+class IconLoader
+{
+  public:
+    static constexpr std::chrono::seconds CACHE_WRITE_DELAY{1};
+
+    using slot_loaded = sigc::slot<void, const Glib::RefPtr<Gdk::Pixbuf>&>;
+
+    IconLoader();
+    ~IconLoader();
+
+    /*!
+     * Queue `path` for decoding at `size` x `size` pixels. `callback` is
+     * called on the main thread once the pixbuf is ready, and not at all if
+     * the file cannot be decoded.
+     */
+    void load(const std::string & path, int size, const slot_loaded & callback);
+
+  private:
+    struct request
+    {
+        uint64_t id;
+        std::string path;
+        int size;
+        Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    };
+
+    struct cache_key
+    {
+        std::string path;
+        int size;
+
+        bool operator ==(const cache_key & other) const
+        {
+            return size == other.size && path == other.path;
+        }
+    };
+
+    struct cache_key_hash
+    {
+        size_t operator ()(const cache_key & key) const
+        {
+            return std::hash<std::string>()(key.path) ^ std::hash<int>()(key.size);
+        }
+    };
+
+    struct cache_entry
+    {
+        int64_t mtime;
+        // either points into the mapped cache file or owns decoded pixels
+        Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    };
+
+    void run();
+    void dispatch();
+    void open_cache();
+    void write_cache();
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<request> pending;
+    std::vector<request> finished;
+    bool stopping = false;
+
+    // only accessed from the worker thread
+    std::string cache_path;
+    MappedFile cache_mapping;
+    std::unordered_map<cache_key, cache_entry, cache_key_hash> cache;
+    bool cache_dirty = false;
+
+    // only accessed from the main thread
+    uint64_t next_id = 0;
+    std::unordered_map<uint64_t, slot_loaded> callbacks;
+    Glib::Dispatcher dispatcher;
+};
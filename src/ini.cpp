@@ -0,0 +1,263 @@
+#include "ini.hpp"
+
+#include <algorithm>
+#include <string_view>
+
+namespace
+{
+enum line_kind
+{
+    LINE_BLANK,
+    LINE_SECTION,
+    LINE_OPTION,
+    LINE_UNKNOWN,
+};
+
+std::string_view trim(std::string_view str)
+{
+    const char *whitespace = " \t\r";
+    size_t begin = str.find_first_not_of(whitespace);
+    if (begin == std::string_view::npos)
+    {
+        return {};
+    }
+
+    return str.substr(begin, str.find_last_not_of(whitespace) - begin + 1);
+}
+
+/* Blank and comment lines are LINE_BLANK. For a section `name` is set to the
+ * section name, for an option to the option name and `value` to its value
+ * without a trailing comment. */
+line_kind classify(std::string_view line, std::string_view & name, std::string_view & value)
+{
+    line = trim(line);
+    if (line.empty() || (line[0] == '#'))
+    {
+        return LINE_BLANK;
+    }
+
+    if (line[0] == '[')
+    {
+        if (line.back() != ']')
+        {
+            return LINE_UNKNOWN;
+        }
+
+        name = trim(line.substr(1, line.size() - 2));
+        return LINE_SECTION;
+    }
+
+    size_t eq = line.find('=');
+    if (eq == std::string_view::npos)
+    {
+        return LINE_UNKNOWN;
+    }
+
+    name  = trim(line.substr(0, eq));
+    value = line.substr(eq + 1);
+    // an unescaped # starts a comment
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        if (value[i] == '\\')
+        {
+            i++;
+        } else if (value[i] == '#')
+        {
+            value = value.substr(0, i);
+            break;
+        }
+    }
+
+    value = trim(value);
+    return name.empty() ? LINE_UNKNOWN : LINE_OPTION;
+}
+}
+
+bool IniFile::parse(const std::string & contents)
+{
+    preamble.clear();
+    sections.clear();
+    section_index.clear();
+    is_valid = false;
+    trailing_newline = contents.empty() || (contents.back() == '\n');
+
+    size_t pos = 0;
+    while (pos < contents.size())
+    {
+        size_t eol = contents.find('\n', pos);
+        if (eol == std::string::npos)
+        {
+            eol = contents.size();
+        }
+
+        std::string_view line(contents.data() + pos, eol - pos);
+        pos = eol + 1;
+
+        std::string_view name, value;
+        switch (classify(line, name, value))
+        {
+          case LINE_BLANK:
+            (sections.empty() ? preamble : sections.back().lines).emplace_back(line);
+            break;
+
+          case LINE_SECTION:
+            // a section given twice is merged by wf-config, we can not patch that
+            if (!section_index.emplace(name, sections.size()).second)
+            {
+                return false;
+            }
+
+            sections.emplace_back();
+            sections.back().lines.emplace_back(line);
+            break;
+
+          case LINE_OPTION:
+          {
+            if (sections.empty())
+            {
+                return false;
+            }
+
+            auto & sec = sections.back();
+            if (!sec.options.emplace(name, sec.lines.size()).second)
+            {
+                return false;
+            }
+
+            sec.lines.emplace_back(line);
+            sec.end = sec.lines.size();
+            break;
+          }
+
+          default:
+            return false;
+        }
+    }
+
+    is_valid = true;
+    return true;
+}
+
+void IniFile::reindex(section & sec)
+{
+    sec.options.clear();
+    sec.end = 1;
+    for (size_t i = 1; i < sec.lines.size(); i++)
+    {
+        std::string_view name, value;
+        if (classify(sec.lines[i], name, value) == LINE_OPTION)
+        {
+            sec.options.emplace(name, i);
+            sec.end = i + 1;
+        }
+    }
+}
+
+int IniFile::update_section(const std::string & block)
+{
+    IniFile parsed;
+    if (!parsed.parse(block) || (parsed.sections.size() != 1))
+    {
+        is_valid = false;
+        return -1;
+    }
+
+    auto & update = parsed.sections.front();
+    std::string_view name, value;
+    classify(update.lines[0], name, value);
+
+    auto it = section_index.find(std::string(name));
+    if (it == section_index.end())
+    {
+        auto & last = sections.empty() ? preamble : sections.back().lines;
+        if (!last.empty() && !trim(last.back()).empty())
+        {
+            last.emplace_back();
+        }
+
+        const int changed = update.lines.size();
+        section_index.emplace(name, sections.size());
+        sections.push_back(std::move(update));
+        trailing_newline = true;
+        return changed;
+    }
+
+    auto & sec  = sections[it->second];
+    int changed = 0;
+
+    std::vector<size_t> removed;
+    for (const auto & [option, line] : sec.options)
+    {
+        if (!update.options.count(option))
+        {
+            removed.push_back(line);
+        }
+    }
+
+    if (!removed.empty())
+    {
+        std::sort(removed.rbegin(), removed.rend());
+        for (size_t line : removed)
+        {
+            sec.lines.erase(sec.lines.begin() + line);
+        }
+
+        reindex(sec);
+        changed += removed.size();
+    }
+
+    // walk the update in order, so new options are added in wf-config's order
+    for (size_t i = 1; i < update.lines.size(); i++)
+    {
+        std::string_view option, new_value;
+        if (classify(update.lines[i], option, new_value) != LINE_OPTION)
+        {
+            continue;
+        }
+
+        auto existing = sec.options.find(std::string(option));
+        if (existing == sec.options.end())
+        {
+            sec.lines.insert(sec.lines.begin() + sec.end, update.lines[i]);
+            sec.options.emplace(option, sec.end++);
+            changed++;
+            continue;
+        }
+
+        std::string_view old_option, old_value;
+        classify(sec.lines[existing->second], old_option, old_value);
+        if (old_value != new_value)
+        {
+            sec.lines[existing->second] = update.lines[i];
+            changed++;
+        }
+    }
+
+    return changed;
+}
+
+std::string IniFile::str() const
+{
+    std::string result;
+    auto append = [&result] (const std::vector<std::string> & lines)
+    {
+        for (const auto & line : lines)
+        {
+            result += line;
+            result += '\n';
+        }
+    };
+
+    append(preamble);
+    for (const auto & sec : sections)
+    {
+        append(sec.lines);
+    }
+
+    if (!trailing_newline && !result.empty())
+    {
+        result.pop_back();
+    }
+
+    return result;
+}
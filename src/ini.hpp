@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * Line index of an INI config file, used to keep the layout of the file when
+ * it is saved. Only the lines of options whose value changed are replaced, so
+ * comments, blank lines and the order of sections and options survive a save.
+ *
+ * This is not incremental I/O: str() builds the whole file, which is then
+ * written and synced in full. Patching only saves serializing the sections
+ * which did not change.
+ */
+class IniFile
+{
+  public:
+    /*!
+     * Index `contents`. Returns false, leaving the index invalid, if the
+     * structure of the file is not understood.
+     */
+    bool parse(const std::string & contents);
+
+    inline bool valid() const
+    {
+        return is_valid;
+    }
+
+    /*!
+     * Make a section hold exactly the options of `block`, a single section
+     * as written by wf-config. Existing options keep their position and
+     * their line is replaced if the value changed, new options are added
+     * after the last option of the section and options
+     * missing from `block` are removed. A section which does not exist yet is
+     * added at the end of the file.
+     *
+     * Returns the number of lines changed, or -1 if `block` could not be
+     * parsed, in which case the index is invalid.
+     */
+    int update_section(const std::string & block);
+
+    std::string str() const;
+
+  private:
+    struct section
+    {
+        // lines[0] is the header
+        std::vector<std::string> lines;
+        // option name -> index in lines
+        std::unordered_map<std::string, size_t> options;
+        // where new options are inserted, right after the last option
+        size_t end = 1;
+    };
+
+    void reindex(section & sec);
+
+    std::vector<std::string> preamble;
+    std::vector<section> sections;
+    std::unordered_map<std::string, size_t> section_index;
+    bool trailing_newline = true;
+    bool is_valid = false;
+};
@@ -0,0 +1,48 @@
+#include "intern.hpp"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+class string_pool
+{
+  public:
+    const std::string *intern(std::string_view str)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(str);
+        if (it != index.end())
+        {
+            return it->second;
+        }
+
+        // deque keeps the strings in place as it grows, so the views stay valid
+        const std::string *pooled = &storage.emplace_back(str);
+        index.emplace(*pooled, pooled);
+        return pooled;
+    }
+
+  private:
+    std::mutex mutex;
+    std::deque<std::string> storage;
+    std::unordered_map<std::string_view, const std::string*> index;
+};
+
+string_pool& get_pool()
+{
+    // never destroyed, handles may outlive static destructors
+    static string_pool *pool = new string_pool();
+    return *pool;
+}
+}
+
+InternedString::InternedString()
+{
+    static const std::string *empty = get_pool().intern({});
+    ptr = empty;
+}
+
+InternedString::InternedString(std::string_view str) : ptr(get_pool().intern(str))
+{}
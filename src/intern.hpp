@@ -0,0 +1,101 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/*!
+ * Handle to an immutable string in a process-wide pool.
+ *
+ * Equal strings share a single copy, so the metadata of all plugins holds
+ * each distinct name, description and label once, and comparing two handles
+ * is a pointer comparison. Interning is thread-safe, the pooled strings live
+ * until the process exits.
+ */
+class InternedString
+{
+  public:
+    InternedString();
+    InternedString(std::string_view str);
+    InternedString(const std::string & str) : InternedString(std::string_view(str))
+    {}
+    InternedString(const char *str) : InternedString(std::string_view(str))
+    {}
+
+    inline const std::string & str() const
+    {
+        return *ptr;
+    }
+
+    inline operator const std::string &() const
+    {
+        return *ptr;
+    }
+
+    inline std::string_view view() const
+    {
+        return *ptr;
+    }
+
+    inline const char *c_str() const
+    {
+        return ptr->c_str();
+    }
+
+    inline size_t length() const
+    {
+        return ptr->length();
+    }
+
+    inline bool empty() const
+    {
+        return ptr->empty();
+    }
+
+    inline bool operator ==(const InternedString & other) const
+    {
+        return ptr == other.ptr;
+    }
+
+    inline bool operator !=(const InternedString & other) const
+    {
+        return ptr != other.ptr;
+    }
+
+  private:
+    const std::string *ptr;
+};
+
+inline bool operator ==(const InternedString & a, const std::string & b)
+{
+    return a.str() == b;
+}
+
+inline bool operator ==(const InternedString & a, const char *b)
+{
+    return a.str() == b;
+}
+
+inline bool operator ==(const InternedString & a, std::string_view b)
+{
+    return a.view() == b;
+}
+
+inline std::ostream& operator <<(std::ostream & out, const InternedString & str)
+{
+    return out << str.str();
+}
+
+/* Interned strings are equal exactly when their pointers are, so hash those */
+namespace std
+{
+template<>
+struct hash<InternedString>
+{
+    size_t operator ()(const InternedString & str) const
+    {
+        return hash<const char*>()(str.c_str());
+    }
+};
+}
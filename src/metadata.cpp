@@ -31,11 +31,30 @@
 #include <wayfire/config/xml.hpp>
 #include <glibmm/i18n.h>
 
-Option::Option(xmlNode *cur_node, Plugin *plugin)
+/*
+ * Add `label` to the labels of an option, which start at `start` in the flat
+ * array `labels`. The labels of an option are added one after the other, so
+ * they are normally at the end of the array already; if not, they are moved
+ * there first.
+ */
+template<class T>
+static void append_label(std::vector<T> & labels, uint32_t & start, uint16_t & count, const T & label)
+{
+    if (start + count != labels.size())
+    {
+        std::vector<T> run(labels.begin() + start, labels.begin() + start + count);
+        start = labels.size();
+        labels.insert(labels.end(), run.begin(), run.end());
+    }
+
+    labels.push_back(label);
+    count++;
+}
+
+void Option::parse_xml(xmlNode *cur_node)
 {
     xmlNode *node;
     xmlChar *prop;
-    this->plugin = plugin;
     prop = xmlGetProp(cur_node, (xmlChar*)"name");
     if (prop)
     {
@@ -46,75 +65,73 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
     prop = xmlGetProp(cur_node, (xmlChar*)"type");
     if (prop)
     {
-        std::string type = (char*)prop;
-        if (type == "int")
-        {
-            this->type     = OPTION_TYPE_INT;
-            this->data.min = -DBL_MAX;
-            this->data.max = DBL_MAX;
-        } else if (type == "double")
-        {
-            this->type     = OPTION_TYPE_DOUBLE;
-            this->data.min = -DBL_MAX;
-            this->data.max = DBL_MAX;
-            this->data.precision = 0.1;
-        } else if (type == "bool")
-        {
-            this->type = OPTION_TYPE_BOOL;
-        } else if (type == "string")
-        {
-            this->type = OPTION_TYPE_STRING;
-            this->default_value = "";
-            this->data.hints    = (hint_type)0;
-        } else if (type == "button")
-        {
-            this->type = OPTION_TYPE_BUTTON;
-            this->default_value = "";
-        } else if (type == "gesture")
-        {
-            this->type = OPTION_TYPE_GESTURE;
-            this->default_value = "";
-        } else if (type == "activator")
-        {
-            this->type = OPTION_TYPE_ACTIVATOR;
-            this->default_value = "";
-        } else if (type == "color")
-        {
-            this->type = OPTION_TYPE_COLOR;
-            this->default_value = "";
-        } else if (type == "key")
-        {
-            this->type = OPTION_TYPE_KEY;
-            this->default_value = "";
-        } else if (type == "dynamic-list")
-        {
-            this->type = OPTION_TYPE_DYNAMIC_LIST;
-        } else if (type == "animation")
-        {
-            this->type     = OPTION_TYPE_ANIMATION;
-            this->data.min = 0;
-            this->data.max = DBL_MAX;
+        std::string type_name = (char*)prop;
+        if (type_name == "int")
+        {
+            set_type(OPTION_TYPE_INT);
+            edit_data().min = -DBL_MAX;
+            edit_data().max = DBL_MAX;
+        } else if (type_name == "double")
+        {
+            set_type(OPTION_TYPE_DOUBLE);
+            edit_data().min = -DBL_MAX;
+            edit_data().max = DBL_MAX;
+            edit_data().precision = 0.1;
+        } else if (type_name == "bool")
+        {
+            set_type(OPTION_TYPE_BOOL);
+        } else if (type_name == "string")
+        {
+            set_type(OPTION_TYPE_STRING);
+            set_default("");
+        } else if (type_name == "button")
+        {
+            set_type(OPTION_TYPE_BUTTON);
+            set_default("");
+        } else if (type_name == "gesture")
+        {
+            set_type(OPTION_TYPE_GESTURE);
+            set_default("");
+        } else if (type_name == "activator")
+        {
+            set_type(OPTION_TYPE_ACTIVATOR);
+            set_default("");
+        } else if (type_name == "color")
+        {
+            set_type(OPTION_TYPE_COLOR);
+            set_default("");
+        } else if (type_name == "key")
+        {
+            set_type(OPTION_TYPE_KEY);
+            set_default("");
+        } else if (type_name == "dynamic-list")
+        {
+            set_type(OPTION_TYPE_DYNAMIC_LIST);
+        } else if (type_name == "animation")
+        {
+            set_type(OPTION_TYPE_ANIMATION);
+            edit_data().min = 0;
+            edit_data().max = DBL_MAX;
         } else
         {
             printf("WARN: [%s] unknown option type: %s\n", plugin->name.c_str(),
                 prop);
-            this->type = OPTION_TYPE_UNDEFINED;
+            set_type(OPTION_TYPE_UNDEFINED);
         }
     } else
     {
         printf("WARN: [%s] no option type found\n", plugin->name.c_str());
-        this->type = OPTION_TYPE_UNDEFINED;
+        set_type(OPTION_TYPE_UNDEFINED);
     }
 
     free(prop);
     prop = xmlGetProp(cur_node, (xmlChar*)"hidden");
     if (prop && (std::string((char*)prop) == "true"))
     {
-        this->hidden = true;
+        set_hidden(true);
     }
 
     free(prop);
-    std::string gettext_domain_name = "wf-plugin-" + plugin->name;
     for (node = cur_node->children; node; node = node->next)
     {
         if (node->type != XML_ELEMENT_NODE)
@@ -125,10 +142,10 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
         std::string node_name = (char*)node->name;
         if (node_name == "_short")
         {
-            this->disp_name = dgettext(gettext_domain_name.c_str(), (char*)node->children->content);
+            this->disp_name = plugin->translate((char*)node->children->content);
         } else if (node_name == "_long")
         {
-            this->tooltip = dgettext(gettext_domain_name.c_str(), (char*)node->children->content);
+            this->tooltip = plugin->translate((char*)node->children->content);
         } else if (node_name == "default")
         {
             if (!node->children)
@@ -136,30 +153,30 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
                 continue;
             }
 
-            switch (this->type)
+            switch (type())
             {
               case OPTION_TYPE_INT:
-                this->default_value = atoi((char*)node->children->content);
+                set_default(atoi((char*)node->children->content));
                 break;
 
               case OPTION_TYPE_ANIMATION:
-                this->default_value = (char*)node->children->content;
+                set_default((char*)node->children->content);
                 break;
 
               case OPTION_TYPE_BOOL:
                 if (std::string((char*)node->children->content) == "true")
                 {
-                    this->default_value = 1;
+                    set_default(1);
                 } else if (std::string((char*)node->children->content) == "false")
                 {
-                    this->default_value = 0;
+                    set_default(0);
                 } else
                 {
-                    this->default_value = atoi((char*)node->children->content);
+                    set_default(atoi((char*)node->children->content));
                 }
 
-                if ((std::get<int>(this->default_value) < 0) &&
-                    (std::get<int>(this->default_value) > 1))
+                if ((default_int() < 0) &&
+                    (default_int() > 1))
                 {
                     printf("WARN: [%s] unknown bool option default\n",
                         plugin->name.c_str());
@@ -173,20 +190,20 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
               case OPTION_TYPE_BUTTON:
               case OPTION_TYPE_COLOR:
               case OPTION_TYPE_KEY:
-                this->default_value = (char*)node->children->content;
+                set_default((char*)node->children->content);
                 break;
 
               case OPTION_TYPE_DOUBLE:
-                this->default_value = atof((char*)node->children->content);
+                set_default(atof((char*)node->children->content));
                 break;
 
               default:
                 break;
             }
-        } else if ((node_name == "type") && (this->type == OPTION_TYPE_DYNAMIC_LIST))
+        } else if ((node_name == "type") && (type() == OPTION_TYPE_DYNAMIC_LIST))
         {
-            char *type = (char*)node->children->content;
-            this->default_value = type;
+            char *list_type = (char*)node->children->content;
+            set_default(list_type);
         } else if (node_name == "min")
         {
             if (!node->children)
@@ -194,15 +211,15 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
                 continue;
             }
 
-            if ((this->type != OPTION_TYPE_INT) &&
-                (this->type != OPTION_TYPE_DOUBLE) &&
-                (this->type != OPTION_TYPE_ANIMATION))
+            if ((type() != OPTION_TYPE_INT) &&
+                (type() != OPTION_TYPE_DOUBLE) &&
+                (type() != OPTION_TYPE_ANIMATION))
             {
                 printf("WARN: [%s] min defined for option type !int && !double\n",
                     plugin->name.c_str());
             }
 
-            this->data.min = atof((char*)node->children->content);
+            edit_data().min = atof((char*)node->children->content);
         } else if (node_name == "max")
         {
             if (!node->children)
@@ -210,15 +227,15 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
                 continue;
             }
 
-            if ((this->type != OPTION_TYPE_INT) &&
-                (this->type != OPTION_TYPE_DOUBLE) &&
-                (this->type != OPTION_TYPE_ANIMATION))
+            if ((type() != OPTION_TYPE_INT) &&
+                (type() != OPTION_TYPE_DOUBLE) &&
+                (type() != OPTION_TYPE_ANIMATION))
             {
                 printf("WARN: [%s] max defined for option type !int && !double\n",
                     plugin->name.c_str());
             }
 
-            this->data.max = atof((char*)node->children->content);
+            edit_data().max = atof((char*)node->children->content);
         } else if (node_name == "precision")
         {
             if (!node->children)
@@ -226,13 +243,13 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
                 continue;
             }
 
-            if (this->type != OPTION_TYPE_DOUBLE)
+            if (type() != OPTION_TYPE_DOUBLE)
             {
                 printf("WARN: [%s] precision defined for option type !double\n",
                     plugin->name.c_str());
             }
 
-            this->data.precision = atof((char*)node->children->content);
+            edit_data().precision = atof((char*)node->children->content);
         } else if (node_name == "hint")
         {
             if (!node->children)
@@ -240,8 +257,8 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
                 continue;
             }
 
-            if ((this->type != OPTION_TYPE_STRING) &&
-                (this->type != OPTION_TYPE_DYNAMIC_LIST))
+            if ((type() != OPTION_TYPE_STRING) &&
+                (type() != OPTION_TYPE_DYNAMIC_LIST))
             {
                 printf("WARN: [%s] hint defined for option type !string\n",
                     plugin->name.c_str());
@@ -249,17 +266,17 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
 
             if (std::string((char*)node->children->content) == "file")
             {
-                this->data.hints = (hint_type)(this->data.hints | HINT_FILE);
+                edit_data().hints = (hint_type)(get_data().hints | HINT_FILE);
             }
 
             if (std::string((char*)node->children->content) == "directory")
             {
-                this->data.hints = (hint_type)(this->data.hints | HINT_DIRECTORY);
+                edit_data().hints = (hint_type)(get_data().hints | HINT_DIRECTORY);
             }
         } else if (node_name == "desc")
         {
-            if ((this->type != OPTION_TYPE_INT) &&
-                (this->type != OPTION_TYPE_STRING))
+            if ((type() != OPTION_TYPE_INT) &&
+                (type() != OPTION_TYPE_STRING))
             {
                 printf("WARN: [%s] desc defined for option type !int && !string\n",
                     plugin->name.c_str());
@@ -272,7 +289,7 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
             {
                 if (n->type == XML_ELEMENT_NODE)
                 {
-                    if (this->type == OPTION_TYPE_INT)
+                    if (type() == OPTION_TYPE_INT)
                     {
                         int is_value = (std::string((char*)n->name) == "value");
                         int is_name  = (std::string((char*)n->name) == "_name");
@@ -288,10 +305,9 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
 
                         if (is_name)
                         {
-                            li->name =
-                                dgettext(gettext_domain_name.c_str(), strdup((char*)n->children->content));
+                            li->name = plugin->translate((char*)n->children->content);
                         }
-                    } else if (this->type == OPTION_TYPE_STRING)
+                    } else if (type() == OPTION_TYPE_STRING)
                     {
                         int is_value = (std::string((char*)n->name) == "value");
                         int is_name  = (std::string((char*)n->name) == "_name");
@@ -303,17 +319,16 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
                         if (is_value)
                         {
                             ls->value = (char*)n->children->content;
-                            if (std::get<std::string>(this->default_value).empty() &&
-                                (this->str_labels.size() == 1))
+                            if (default_string().empty() &&
+                                (str_labels().size() == 1))
                             {
-                                this->default_value = ls->value;
+                                set_default(ls->value);
                             }
                         }
 
                         if (is_name)
                         {
-                            ls->name =
-                                dgettext(gettext_domain_name.c_str(), strdup((char*)n->children->content));
+                            ls->name = plugin->translate((char*)n->children->content);
                         }
                     }
                 }
@@ -321,48 +336,113 @@ Option::Option(xmlNode *cur_node, Plugin *plugin)
 
             if (li)
             {
-                std::pair<std::string, int> pair(li->name, li->value);
-                int_labels.push_back(pair);
+                add_int_label(li->name, li->value);
             }
 
             if (ls)
             {
-                std::pair<std::string, std::string> pair(ls->name, ls->value);
-                str_labels.push_back(pair);
+                add_str_label(ls->name, ls->value);
             }
         }
     }
 }
 
-Option::Option(option_type group_type, Plugin *plugin) : plugin(plugin), type(
-        group_type)
-{}
+Option*Option::create_child_option(const std::string & name, option_type type)
+{
+    auto *option = store->create(plugin, type);
+    option->name   = name;
+    option->parent = this;
+    options.push_back(option);
+    return option;
+}
+
+void Option::remove_child(Option *child)
+{
+    options.erase(std::remove(options.begin(), options.end(), child), options.end());
+    store->release(child);
+}
 
-Option::~Option()
+void Option::clear_children()
 {
-    if (parent)
+    for (auto *child : options)
     {
-        auto & children = parent->options;
-        children.erase(std::remove(children.begin(),
-            children.end(), this), children.end());
+        store->release(child);
     }
+
+    options.clear();
 }
 
-Option*Option::create_child_option(const std::string & name, option_type type)
+void Option::add_int_label(const InternedString & name, int value)
 {
-    auto *option = new Option();
-    option->name   = name;
-    option->parent = this;
-    options.push_back(option);
+    append_label(store->int_labels, store->int_label_start[id], store->int_label_count[id],
+        int_label(name, value));
+}
+
+void Option::add_str_label(const InternedString & name, const InternedString & value)
+{
+    append_label(store->str_labels, store->str_label_start[id], store->str_label_count[id],
+        str_label(name, value));
+}
+
+Option*OptionStore::create(Plugin *plugin, option_type type)
+{
+    Option *option;
+    uint32_t id;
+    if (free_list.empty())
+    {
+        id     = options.size();
+        option = &options.emplace_back();
+        types.push_back(type);
+        flags.push_back(0);
+        default_kinds.push_back(DEFAULT_INT);
+        default_numbers.push_back(0);
+        default_strings.emplace_back();
+        data_index.push_back(NO_DATA);
+        int_label_start.push_back(0);
+        str_label_start.push_back(0);
+        int_label_count.push_back(0);
+        str_label_count.push_back(0);
+    } else
+    {
+        option = free_list.back();
+        free_list.pop_back();
+        id      = option->id;
+        *option = Option();
+        types[id]  = type;
+        flags[id]  = 0;
+        default_kinds[id]   = DEFAULT_INT;
+        default_numbers[id] = 0;
+        default_strings[id] = InternedString();
+        // the option keeps its slot in `data`, if it had one
+        if (data_index[id] != NO_DATA)
+        {
+            data[data_index[id]] = var_data();
+        }
+    }
+
     option->plugin = plugin;
-    option->type   = type;
+    option->store  = this;
+    option->id     = id;
     return option;
 }
 
-Plugin*Plugin::get_plugin_data(xmlNode *cur_node, Option *main_group, Plugin *plugin)
+void OptionStore::release(Option *option)
+{
+    for (auto *child : option->options)
+    {
+        release(child);
+    }
+
+    int_label_count[option->id] = 0;
+    str_label_count[option->id] = 0;
+    option->options.clear();
+    option->parent = nullptr;
+    free_list.push_back(option);
+}
+
+Plugin*Plugin::get_plugin_data(xmlNode *cur_node, Plugin *plugin)
 {
     xmlChar *prop;
-    bool children_handled = false;
 
     for (; cur_node; cur_node = cur_node->next)
     {
@@ -377,48 +457,200 @@ Plugin*Plugin::get_plugin_data(xmlNode *cur_node, Option *main_group, Plugin *pl
             return nullptr;
         }
 
-        if (cur_node_name == "plugin")
+        if (cur_node_name != "plugin")
         {
-            plugin = new Plugin();
-            plugin->category = _("Uncategorized");
-            prop = xmlGetProp(cur_node, (xmlChar*)"name");
-            if (prop)
-            {
-                plugin->name = (char*)prop;
-                // Initialise translations
-                bindtextdomain(("wf-plugin-" + plugin->name).c_str(), WAYFIRE_LOCALEDIR);
-            }
+            plugin = get_plugin_data(cur_node->children, plugin);
+            continue;
+        }
 
-            free(prop);
-        } else if (cur_node_name == "_short")
+        if (!plugin)
         {
-            plugin->disp_name = (char*)cur_node->children->content;
-        } else if (cur_node_name == "_long")
+            plugin = new Plugin();
+        }
+
+        plugin->category = _("Uncategorized");
+        plugin->xml_node = cur_node;
+        prop = xmlGetProp(cur_node, (xmlChar*)"name");
+        if (prop)
         {
-            plugin->tooltip = (char*)cur_node->children->content;
-        } else if (cur_node_name == "category")
+            plugin->name = (char*)prop;
+        }
+
+        free(prop);
+
+        // Only the header is read here, options are loaded by load_options()
+        for (xmlNode *node = cur_node->children; node; node = node->next)
         {
-            if (!cur_node->children)
+            if (node->type != XML_ELEMENT_NODE)
             {
                 continue;
             }
 
-            plugin->category = (char*)cur_node->children->content;
-        } else if (cur_node_name == "option")
+            std::string node_name = (char*)node->name;
+            if (node_name == "_short")
+            {
+                plugin->disp_name = (char*)node->children->content;
+            } else if (node_name == "_long")
+            {
+                plugin->tooltip = (char*)node->children->content;
+            } else if (node_name == "category")
+            {
+                if (!node->children)
+                {
+                    continue;
+                }
+
+                plugin->category = (char*)node->children->content;
+            }
+        }
+    }
+
+    return plugin;
+}
+
+std::vector<Plugin*> Plugin::get_plugins_data(wf::config::config_manager_t & config_manager,
+    StartupProfiler *profiler)
+{
+    std::vector<xmlNode*> roots;
+    for (auto & s : config_manager.get_all_sections())
+    {
+        xmlNode *root_element = wf::config::xml::get_section_xml_node(s);
+
+        if (!root_element)
+        {
+            continue;
+        }
+
+        root_element = root_element->parent;
+        std::string root_name = (char*)root_element->name;
+
+        if ((root_element->type == XML_ELEMENT_NODE) &&
+            ((root_name == "wayfire") || (root_name == "wf-shell")))
+        {
+            roots.push_back(root_element);
+        }
+    }
+
+    // Sections are independent, so parse them in parallel and merge the
+    // results in section order to keep the plugin list deterministic.
+    std::vector<Plugin*> parsed(roots.size(), nullptr);
+    std::vector<StartupProfiler::clock::duration> parse_times(roots.size());
+    parallel_for(roots.size(), [&] (size_t i)
+    {
+        auto start = StartupProfiler::clock::now();
+        Plugin *p  = Plugin::get_plugin_data(roots[i]);
+        parse_times[i] = StartupProfiler::clock::now() - start;
+        if (!p)
+        {
+            return;
+        }
+
+        std::string root_name = (char*)roots[i]->name;
+        if (root_name == "wayfire")
+        {
+            p->type = PLUGIN_TYPE_WAYFIRE;
+        } else if (root_name == "wf-shell")
+        {
+            p->type = PLUGIN_TYPE_WF_SHELL;
+        } else
+        {
+            // Should be unreachable because `root_name` is "wayfire" or
+            // "wf-shell"
+            p->type = PLUGIN_TYPE_NONE;
+        }
+
+        parsed[i] = p;
+    });
+
+    std::vector<Plugin*> plugins;
+    for (size_t i = 0; i < roots.size(); i++)
+    {
+        if (!parsed[i])
+        {
+            continue;
+        }
+
+        printf("Loading %s plugin: %s\n", roots[i]->name, parsed[i]->name.c_str());
+        if (profiler)
+        {
+            profiler->add_plugin(parsed[i]->name, parse_times[i]);
+        }
+
+        plugins.push_back(parsed[i]);
+    }
+
+    return plugins;
+}
+
+void Plugin::load_options()
+{
+    if (options_loaded)
+    {
+        return;
+    }
+
+    options_loaded = true;
+    if (xml_node)
+    {
+        parse_options(xml_node->children, nullptr);
+    } else if (cache)
+    {
+        cache->load_options(this);
+    }
+}
+
+const InternedString& Plugin::translate(const InternedString & msgid)
+{
+    // gettext maps the empty msgid to the header of the catalog
+    if (msgid.empty())
+    {
+        return msgid;
+    }
+
+    auto it = translations.find(msgid);
+    if (it != translations.end())
+    {
+        return it->second;
+    }
+
+    if (text_domain.empty())
+    {
+        text_domain = "wf-plugin-" + name;
+        bindtextdomain(text_domain.c_str(), WAYFIRE_LOCALEDIR);
+    }
+
+    return translations.emplace(msgid, dgettext(text_domain.c_str(), msgid.c_str())).first->second;
+}
+
+void Plugin::parse_options(xmlNode *cur_node, Option *main_group)
+{
+    bool children_handled = false;
+
+    for (; cur_node; cur_node = cur_node->next)
+    {
+        if (cur_node->type != XML_ELEMENT_NODE)
+        {
+            continue;
+        }
+
+        std::string cur_node_name = (char*)cur_node->name;
+        if (cur_node_name == "option")
         {
             if (!main_group)
             {
-                main_group = new Option(OPTION_TYPE_GROUP, plugin);
+                main_group = option_store.create(this, OPTION_TYPE_GROUP);
                 main_group->name = _("General");
-                plugin->option_groups.push_back(main_group);
+                option_groups.push_back(main_group);
             }
 
             children_handled = true;
-            main_group->options.push_back(new Option(cur_node, plugin));
+            Option *option = option_store.create(this);
+            option->parse_xml(cur_node);
+            main_group->options.push_back(option);
         } else if (cur_node_name == "group")
         {
             xmlNode *node;
-            Option *group = new Option(OPTION_TYPE_GROUP, plugin);
+            Option *group = option_store.create(this, OPTION_TYPE_GROUP);
             for (node = cur_node->children; node; node = node->next)
             {
                 if (node->type != XML_ELEMENT_NODE)
@@ -432,10 +664,12 @@ Plugin*Plugin::get_plugin_data(xmlNode *cur_node, Option *main_group, Plugin *pl
                     group->name = (char*)node->children->content;
                 } else if (node_name == "option")
                 {
-                    group->options.push_back(new Option(node, plugin));
+                    Option *option = option_store.create(this);
+                    option->parse_xml(node);
+                    group->options.push_back(option);
                 } else if (node_name == "subgroup")
                 {
-                    Option *subgroup = new Option(OPTION_TYPE_SUBGROUP, plugin);
+                    Option *subgroup = option_store.create(this, OPTION_TYPE_SUBGROUP);
                     for (xmlNode *n = node->children; n; n = n->next)
                     {
                         if (n->type != XML_ELEMENT_NODE)
@@ -448,7 +682,9 @@ Plugin*Plugin::get_plugin_data(xmlNode *cur_node, Option *main_group, Plugin *pl
                             subgroup->name = (char*)n->children->content;
                         } else if (std::string((char*)n->name) == "option")
                         {
-                            subgroup->options.push_back(new Option(n, plugin));
+                            Option *option = option_store.create(this);
+                            option->parse_xml(n);
+                            subgroup->options.push_back(option);
                         }
                     }
 
@@ -457,14 +693,12 @@ Plugin*Plugin::get_plugin_data(xmlNode *cur_node, Option *main_group, Plugin *pl
             }
 
             children_handled = true;
-            plugin->option_groups.push_back(group);
+            option_groups.push_back(group);
         }
 
         if (!children_handled)
         {
-            plugin = get_plugin_data(cur_node->children, main_group, plugin);
+            parse_options(cur_node->children, main_group);
         }
     }
-
-    return plugin;
 }
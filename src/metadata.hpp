@@ -1,10 +1,13 @@
 #pragma once
 
+#include <deque>
 #include <gtkmm.h>
 #include <string>
-#include <variant>
+#include <unordered_map>
 #include <wayfire/config/xml.hpp>
 
+#include "intern.hpp"
+#include "metrics.hpp"
 #include "utils.hpp"
 #include "wcm.hpp"
 
@@ -63,16 +66,59 @@ struct LabeledString
 
 struct var_data
 {
-    double min;
-    double max;
-    double precision;
-    hint_type hints;
+    double min = 0;
+    double max = 0;
+    double precision = 0;
+    hint_type hints  = (hint_type)0;
 };
 
-using opt_data = std::variant<int, std::string, double>;
+using int_label = std::pair<InternedString, int>;
+using str_label = std::pair<InternedString, InternedString>;
+
+/*!
+ * The labels of one option, a contiguous run of a flat label array of its
+ * OptionStore. Only valid until labels are added to the store.
+ */
+template<class T>
+class label_range
+{
+  public:
+    label_range(const T *first, size_t count) : first(first), last(first + count)
+    {}
+
+    inline const T *begin() const
+    {
+        return first;
+    }
+
+    inline const T *end() const
+    {
+        return last;
+    }
+
+    inline size_t size() const
+    {
+        return last - first;
+    }
+
+    inline bool empty() const
+    {
+        return first == last;
+    }
+
+  private:
+    const T *first;
+    const T *last;
+};
 
 class Plugin;
 
+class OptionStore;
+
+/*!
+ * Node of the option tree of a plugin. The data of the option lives in the
+ * plugin's OptionStore, under the id of the option.
+ */
 class Option
 {
     template<class value_type>
@@ -85,59 +131,282 @@ class Option
     }
 
   public:
-    Option(xmlNode *cur_node, Plugin *plugin);
-    Option(option_type group_type, Plugin *plugin);
-    Option() = default;
-    ~Option();
+    /*!
+     * Read the option from its metadata XML node.
+     */
+    void parse_xml(xmlNode *cur_node);
 
+    /*!
+     * Add a child option allocated from the plugin's option store.
+     */
     Option *create_child_option(const std::string & name, option_type type);
+    /*!
+     * Detach `child` and give it back to the option store for reuse.
+     */
+    void remove_child(Option *child);
+    /*!
+     * Give all children back to the option store, used by dynamic lists which
+     * recreate their children whenever the page is built.
+     */
+    void clear_children();
 
-    Plugin *plugin;
-    std::string name;
-    std::string disp_name;
-    std::string tooltip;
-    std::string binding;
-    option_type type;
-    mod_type mod_mask;
-    opt_data default_value;
-    var_data data;
-    Option *parent;
-    bool hidden = false;
+    inline option_type type() const;
+    inline void set_type(option_type type);
+    inline bool hidden() const;
+    inline void set_hidden(bool hidden);
+    /*!
+     * The default value, read as the type it was set with. Int, bool and
+     * double options have a number, the others a string.
+     */
+    inline int default_int() const;
+    inline double default_double() const;
+    inline const std::string & default_string() const;
+    inline void set_default(int value);
+    inline void set_default(double value);
+    inline void set_default(const InternedString & value);
+    /*!
+     * Range, precision and hints, all zero for options without them.
+     */
+    inline const var_data & get_data() const;
+    inline var_data & edit_data();
+    inline label_range<int_label> int_labels() const;
+    inline label_range<str_label> str_labels() const;
+    void add_int_label(const InternedString & name, int value);
+    void add_str_label(const InternedString & name, const InternedString & value);
 
+    Plugin *plugin     = nullptr;
+    OptionStore *store = nullptr;
+    uint32_t id = 0;
+    InternedString name;
+    InternedString disp_name;
+    InternedString tooltip;
+    Option *parent = nullptr;
     std::vector<Option*> options;
-    std::vector<std::pair<std::string, int>> int_labels;
-    std::vector<std::pair<std::string, std::string>> str_labels;
 
     template<class... ArgTypes>
     void set_save(const ArgTypes &... args);
 };
 
+/*!
+ * Owns the options of a plugin and keeps their data in structure-of-arrays
+ * form, indexed by option id.
+ *
+ * Every option has an entry in each of the dense arrays: type, flags, the
+ * kind of its default value, and the default itself in a typed array, a
+ * double for numbers and an interned string handle for the rest. Ranges and
+ * labels, which only some options have, are stored in flat arrays the dense
+ * arrays point into, so no option allocates anything of its own.
+ *
+ * Option nodes are allocated in chunks and are all freed together with the
+ * store. Released options keep their id and go on a free list, to be handed
+ * out again by create(), so rebuilding dynamic lists does not grow the store.
+ * The labels of a released option stay in the flat arrays until the store is
+ * freed.
+ */
+class OptionStore
+{
+  public:
+    enum option_flags : uint8_t
+    {
+        FLAG_HIDDEN = 1 << 0,
+    };
+
+    /* Same order as the default records of the metadata cache */
+    enum default_kind : uint8_t
+    {
+        DEFAULT_INT    = 0,
+        DEFAULT_STRING = 1,
+        DEFAULT_DOUBLE = 2,
+    };
+
+    static constexpr uint32_t NO_DATA = UINT32_MAX;
+
+    Option *create(Plugin *plugin, option_type type = OPTION_TYPE_UNDEFINED);
+    /*!
+     * Put `option` and all its children on the free list.
+     */
+    void release(Option *option);
+
+    inline size_t size() const
+    {
+        return types.size();
+    }
+
+    inline Option *get(uint32_t id)
+    {
+        return &options[id];
+    }
+
+    // dense, one entry per option id
+    std::vector<uint8_t> types;
+    std::vector<uint8_t> flags;
+    std::vector<uint8_t> default_kinds;
+    // ints are stored as doubles, which hold every int exactly
+    std::vector<double> default_numbers;
+    std::vector<InternedString> default_strings;
+    // index into `data`, or NO_DATA
+    std::vector<uint32_t> data_index;
+    // first label and number of labels in `int_labels` and `str_labels`
+    std::vector<uint32_t> int_label_start;
+    std::vector<uint32_t> str_label_start;
+    std::vector<uint16_t> int_label_count;
+    std::vector<uint16_t> str_label_count;
+
+    // flat, referenced from the dense arrays
+    std::vector<var_data> data;
+    std::vector<int_label> int_labels;
+    std::vector<str_label> str_labels;
+
+  private:
+    // options[id], a deque never moves its elements so Option pointers stay valid
+    std::deque<Option> options;
+    std::vector<Option*> free_list;
+};
+
+option_type Option::type() const
+{
+    return (option_type)store->types[id];
+}
+
+void Option::set_type(option_type type)
+{
+    store->types[id] = type;
+}
+
+bool Option::hidden() const
+{
+    return store->flags[id] & OptionStore::FLAG_HIDDEN;
+}
+
+void Option::set_hidden(bool hidden)
+{
+    if (hidden)
+    {
+        store->flags[id] |= OptionStore::FLAG_HIDDEN;
+    } else
+    {
+        store->flags[id] &= ~OptionStore::FLAG_HIDDEN;
+    }
+}
+
+int Option::default_int() const
+{
+    return (int)store->default_numbers[id];
+}
+
+double Option::default_double() const
+{
+    return store->default_numbers[id];
+}
+
+const std::string & Option::default_string() const
+{
+    return store->default_strings[id];
+}
+
+void Option::set_default(int value)
+{
+    store->default_kinds[id]   = OptionStore::DEFAULT_INT;
+    store->default_numbers[id] = value;
+}
+
+void Option::set_default(double value)
+{
+    store->default_kinds[id]   = OptionStore::DEFAULT_DOUBLE;
+    store->default_numbers[id] = value;
+}
+
+void Option::set_default(const InternedString & value)
+{
+    store->default_kinds[id]   = OptionStore::DEFAULT_STRING;
+    store->default_strings[id] = value;
+}
+
+const var_data & Option::get_data() const
+{
+    static const var_data none;
+    uint32_t index = store->data_index[id];
+    return index == OptionStore::NO_DATA ? none : store->data[index];
+}
+
+var_data & Option::edit_data()
+{
+    uint32_t & index = store->data_index[id];
+    if (index == OptionStore::NO_DATA)
+    {
+        index = store->data.size();
+        store->data.emplace_back();
+    }
+
+    return store->data[index];
+}
+
+label_range<int_label> Option::int_labels() const
+{
+    return {store->int_labels.data() + store->int_label_start[id], store->int_label_count[id]};
+}
+
+label_range<str_label> Option::str_labels() const
+{
+    return {store->str_labels.data() + store->str_label_start[id], store->str_label_count[id]};
+}
+
 class WCM;
+class MetadataCache;
 
 class Plugin
 {
   public:
     std::string name;
-    std::string disp_name;
-    std::string tooltip;
-    std::string category;
+    InternedString disp_name;
+    InternedString tooltip;
+    InternedString category;
     plugin_type type;
     bool enabled;
+    // only valid after load_options()
     std::vector<Option*> option_groups;
+    // owns every Option of the plugin
+    OptionStore option_store;
+    // emitted when `enabled` changes
+    sigc::signal<void> enabled_changed;
+
+    // where the options are loaded from, either the XML or the metadata cache
+    xmlNode *xml_node = nullptr;
+    const MetadataCache *cache = nullptr;
+    uint64_t cache_offset = 0;
+    bool options_loaded   = false;
 
-    // widget of the plugin which is shown on the main page
-    Gtk::Box widget = Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 5);
-    Gtk::CheckButton enabled_check;
-    Gtk::Button button;
-    Gtk::Box button_layout = Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 5);
-    Gtk::Image icon;
-    Gtk::Label label;
-
-    static Plugin *get_plugin_data(xmlNode *node, Option *main_group = nullptr,
-        Plugin *plugin = nullptr);
-    void init_widget();
+    /*!
+     * Read the plugin header (name, description and category) from the
+     * metadata XML. The options are not parsed until load_options().
+     */
+    static Plugin *get_plugin_data(xmlNode *node, Plugin *plugin = nullptr);
+    /*!
+     * Read the header of every plugin described in the wayfire or wf-shell
+     * metadata of `config_manager`, in section order. The parse time of each
+     * plugin is added to `profiler` if it is set.
+     */
+    static std::vector<Plugin*> get_plugins_data(wf::config::config_manager_t & config_manager,
+        StartupProfiler *profiler = nullptr);
+    /*!
+     * Build the option tree of the plugin, if it was not built yet.
+     */
+    void load_options();
+    /*!
+     * Translate `msgid` in the text domain of the plugin. The domain is bound
+     * on the first call and every translation is looked up only once.
+     * Main thread only.
+     */
+    const InternedString& translate(const InternedString & msgid);
     inline bool is_core_plugin()
     {
         return name == "core" || name == "input" || name == "workarounds";
     }
+
+  private:
+    void parse_options(xmlNode *node, Option *main_group);
+
+    // empty until the text domain is bound
+    std::string text_domain;
+    std::unordered_map<InternedString, InternedString> translations;
 };
@@ -0,0 +1,367 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+std::string json_string(const std::string & str)
+{
+    std::string result = "\"";
+    for (char c : str)
+    {
+        switch (c)
+        {
+          case '"':
+            result += "\\\"";
+            break;
+
+          case '\\':
+            result += "\\\\";
+            break;
+
+          case '\n':
+            result += "\\n";
+            break;
+
+          default:
+            if ((unsigned char)c < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                result += buf;
+            } else
+            {
+                result += c;
+            }
+        }
+    }
+
+    return result + "\"";
+}
+
+std::string json_ms(StartupProfiler::clock::duration duration)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f",
+        std::chrono::duration<double, std::milli>(duration).count());
+    return buf;
+}
+
+std::string summary_line(const char *name, const Histogram & histogram, double scale)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%-20s min %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", name,
+        histogram.min() / scale, histogram.percentile(50) / scale,
+        histogram.percentile(90) / scale, histogram.percentile(99) / scale,
+        histogram.max() / scale);
+    return buf;
+}
+}
+
+StartupProfiler::Scope::Scope(StartupProfiler *profiler, const std::string & name) :
+    profiler(profiler), name(name), start(clock::now())
+{}
+
+StartupProfiler::Scope::~Scope()
+{
+    profiler->add_phase(name, start, clock::now());
+}
+
+StartupProfiler::StartupProfiler() : origin(clock::now())
+{}
+
+void StartupProfiler::set_output(const std::string & path)
+{
+    output = path;
+}
+
+void StartupProfiler::add_phase(const std::string & name, clock::time_point start,
+    clock::time_point end)
+{
+    if (enabled())
+    {
+        phases.push_back({name, start, end});
+    }
+}
+
+void StartupProfiler::mark(const std::string & name)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    for (const auto & [mark_name, time] : marks)
+    {
+        if (mark_name == name)
+        {
+            return;
+        }
+    }
+
+    marks.emplace_back(name, clock::now());
+}
+
+void StartupProfiler::add_plugin(const std::string & name, clock::duration parse_time)
+{
+    if (enabled())
+    {
+        plugins.push_back({name, parse_time});
+    }
+}
+
+std::string StartupProfiler::to_json() const
+{
+    std::string json = "{\n  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+    {
+        json += i ? ",\n    " : "\n    ";
+        json += "{\"name\": " + json_string(phases[i].name) +
+            ", \"start_ms\": " + json_ms(phases[i].start - origin) +
+            ", \"duration_ms\": " + json_ms(phases[i].end - phases[i].start) + "}";
+    }
+
+    json += "\n  ],\n  \"marks\": [";
+    for (size_t i = 0; i < marks.size(); i++)
+    {
+        json += i ? ",\n    " : "\n    ";
+        json += "{\"name\": " + json_string(marks[i].first) +
+            ", \"time_ms\": " + json_ms(marks[i].second - origin) + "}";
+    }
+
+    json += "\n  ],\n  \"plugins\": [";
+    for (size_t i = 0; i < plugins.size(); i++)
+    {
+        json += i ? ",\n    " : "\n    ";
+        json += "{\"name\": " + json_string(plugins[i].name) +
+            ", \"parse_ms\": " + json_ms(plugins[i].parse_time) + "}";
+    }
+
+    json += "\n  ]\n}\n";
+    return json;
+}
+
+void StartupProfiler::write() const
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    if (output == "-")
+    {
+        std::cout << to_json() << std::flush;
+        return;
+    }
+
+    std::ofstream out(output);
+    out << to_json();
+    if (!out)
+    {
+        std::cerr << "Failed to write startup profile to " << output << std::endl;
+    }
+}
+
+void Histogram::record(uint64_t value)
+{
+    const size_t index = index_of(value);
+    if (index >= counts.size())
+    {
+        counts.resize(index + 1);
+    }
+
+    counts[index]++;
+    total++;
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+    sum += value;
+}
+
+double Histogram::mean() const
+{
+    return total ? sum / total : 0;
+}
+
+uint64_t Histogram::percentile(double percent) const
+{
+    const uint64_t target = std::max<uint64_t>(1, std::ceil(percent / 100 * total));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        seen += counts[i];
+        if (seen >= target)
+        {
+            return std::min(highest_of(i), max_value);
+        }
+    }
+
+    return max_value;
+}
+
+size_t Histogram::index_of(uint64_t value)
+{
+    const int msb = 63 - __builtin_clzll(value | 1);
+    const int shift = std::max(0, msb - SUB_BUCKET_BITS);
+    return (shift << SUB_BUCKET_BITS) + (value >> shift);
+}
+
+uint64_t Histogram::lowest_of(size_t index)
+{
+    if (index < (2u << SUB_BUCKET_BITS))
+    {
+        return index;
+    }
+
+    const int shift = (index >> SUB_BUCKET_BITS) - 1;
+    return uint64_t(index - (shift << SUB_BUCKET_BITS)) << shift;
+}
+
+uint64_t Histogram::highest_of(size_t index)
+{
+    if (index < (2u << SUB_BUCKET_BITS))
+    {
+        return index;
+    }
+
+    const int shift = (index >> SUB_BUCKET_BITS) - 1;
+    return lowest_of(index) + (uint64_t(1) << shift) - 1;
+}
+
+std::string Histogram::to_json() const
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+        "{\"count\": %lu, \"min\": %lu, \"max\": %lu, \"mean\": %.1f, "
+        "\"p50\": %lu, \"p90\": %lu, \"p99\": %lu, \"buckets\": [",
+        (unsigned long)count(), (unsigned long)min(), (unsigned long)max(), mean(),
+        (unsigned long)percentile(50), (unsigned long)percentile(90),
+        (unsigned long)percentile(99));
+
+    // only the buckets in use, as [lowest value, count]
+    std::string json = buf;
+    bool first = true;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        if (counts[i])
+        {
+            json += first ? "[" : ", [";
+            json += std::to_string(lowest_of(i)) + ", " + std::to_string(counts[i]) + "]";
+            first = false;
+        }
+    }
+
+    return json + "]}";
+}
+
+void SaveMetrics::set_print(bool print)
+{
+    this->print = print;
+}
+
+void SaveMetrics::set_output(const std::string & path)
+{
+    output = path;
+}
+
+void SaveMetrics::edit(const std::string & file)
+{
+    if (enabled())
+    {
+        unsaved[file].push_back(clock::now());
+    }
+}
+
+void SaveMetrics::queued(const std::string & file)
+{
+    auto it = unsaved.find(file);
+    if (it != unsaved.end())
+    {
+        auto & waiting = in_flight[file];
+        waiting.insert(waiting.end(), it->second.begin(), it->second.end());
+        unsaved.erase(it);
+    }
+}
+
+void SaveMetrics::serialized(size_t bytes, size_t sections)
+{
+    if (enabled())
+    {
+        this->bytes.record(bytes);
+        this->sections.record(sections);
+    }
+}
+
+void SaveMetrics::written(const std::string & file)
+{
+    auto it = in_flight.find(file);
+    if (it == in_flight.end())
+    {
+        return;
+    }
+
+    const auto now = clock::now();
+    for (const auto & time : it->second)
+    {
+        latency_us.record(std::chrono::duration_cast<std::chrono::microseconds>(now - time).count());
+    }
+
+    in_flight.erase(it);
+}
+
+void SaveMetrics::failed(const std::string & file)
+{
+    auto it = in_flight.find(file);
+    if (it != in_flight.end())
+    {
+        failed_edits += it->second.size();
+        in_flight.erase(it);
+    }
+}
+
+std::string SaveMetrics::summary() const
+{
+    return "Saves: " + std::to_string(bytes.count()) + ", edits saved: " +
+           std::to_string(latency_us.count()) + ", edits failed: " +
+           std::to_string(failed_edits) + "\n" +
+           summary_line("Save latency (ms)", latency_us, 1000) +
+           summary_line("Bytes per save", bytes, 1) +
+           summary_line("Sections per save", sections, 1);
+}
+
+std::string SaveMetrics::to_json() const
+{
+    return "{\n  \"latency_us\": " + latency_us.to_json() +
+           ",\n  \"bytes\": " + bytes.to_json() +
+           ",\n  \"sections\": " + sections.to_json() +
+           ",\n  \"failed_edits\": " + std::to_string(failed_edits) + "\n}\n";
+}
+
+void SaveMetrics::write() const
+{
+    if (print)
+    {
+        std::cout << summary() << std::flush;
+    }
+
+    if (output.empty())
+    {
+        return;
+    }
+
+    if (output == "-")
+    {
+        std::cout << to_json() << std::flush;
+        return;
+    }
+
+    std::ofstream out(output);
+    out << to_json();
+    if (!out)
+    {
+        std::cerr << "Failed to write save metrics to " << output << std::endl;
+    }
+}
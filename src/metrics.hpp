@@ -0,0 +1,201 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * Records how long the phases of the startup take, relative to the creation
+ * of the profiler, and writes them as JSON.
+ *
+ * The profiler does nothing until an output file is set, so it can stay in
+ * place in release builds.
+ */
+class StartupProfiler
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /*!
+     * Measures a phase from its construction until it goes out of scope.
+     */
+    class Scope
+    {
+      public:
+        Scope(StartupProfiler *profiler, const std::string & name);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope& operator =(const Scope &) = delete;
+
+      private:
+        StartupProfiler *profiler;
+        std::string name;
+        clock::time_point start;
+    };
+
+    StartupProfiler();
+
+    /*!
+     * Enable profiling and write the results to `path` in write(), or to the
+     * standard output if `path` is "-".
+     */
+    void set_output(const std::string & path);
+
+    bool enabled() const
+    {
+        return !output.empty();
+    }
+
+    Scope measure(const std::string & phase)
+    {
+        return Scope(this, phase);
+    }
+
+    void add_phase(const std::string & name, clock::time_point start, clock::time_point end);
+    /*!
+     * Record a point in time, only the first mark with a given name is kept.
+     */
+    void mark(const std::string & name);
+    void add_plugin(const std::string & name, clock::duration parse_time);
+
+    std::string to_json() const;
+    void write() const;
+
+  private:
+    struct phase
+    {
+        std::string name;
+        clock::time_point start;
+        clock::time_point end;
+    };
+
+    struct plugin_time
+    {
+        std::string name;
+        clock::duration parse_time;
+    };
+
+    clock::time_point origin;
+    std::string output;
+    std::vector<phase> phases;
+    std::vector<std::pair<std::string, clock::time_point>> marks;
+    std::vector<plugin_time> plugins;
+};
+
+/*!
+ * Histogram of non-negative integers with a bounded relative error, in the
+ * style of HdrHistogram. Values below 64 are counted exactly, above that the
+ * buckets double in width every 32 buckets, so a value is known to within
+ * 1/32 of itself while the histogram stays small for any range.
+ */
+class Histogram
+{
+  public:
+    void record(uint64_t value);
+
+    inline uint64_t count() const
+    {
+        return total;
+    }
+
+    inline uint64_t min() const
+    {
+        return total ? min_value : 0;
+    }
+
+    inline uint64_t max() const
+    {
+        return max_value;
+    }
+
+    double mean() const;
+    /*!
+     * Returns the highest value equivalent to the one below which `percent`
+     * of the recorded values fall.
+     */
+    uint64_t percentile(double percent) const;
+
+    std::string to_json() const;
+
+  private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+
+    static size_t index_of(uint64_t value);
+    static uint64_t lowest_of(size_t index);
+    static uint64_t highest_of(size_t index);
+
+    std::vector<uint64_t> counts;
+    uint64_t total     = 0;
+    uint64_t min_value = UINT64_MAX;
+    uint64_t max_value = 0;
+    double sum = 0;
+};
+
+/*!
+ * Measures the saves of the config files: the time from an edit in the UI
+ * until the file holding it was renamed into place, the size of each write
+ * and the number of sections it touched.
+ *
+ * Like StartupProfiler, nothing is recorded until an output is enabled.
+ */
+class SaveMetrics
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /*!
+     * Print a summary to the standard output in write().
+     */
+    void set_print(bool print);
+    /*!
+     * Write the histograms as JSON to `path` in write(), or to the standard
+     * output if `path` is "-".
+     */
+    void set_output(const std::string & path);
+
+    inline bool enabled() const
+    {
+        return print || !output.empty();
+    }
+
+    /*!
+     * A change to `file` was made.
+     */
+    void edit(const std::string & file);
+    /*!
+     * The changes to `file` so far were handed to the writer.
+     */
+    void queued(const std::string & file);
+    /*!
+     * The writer serialized a save to `bytes` bytes, touching `sections`
+     * sections.
+     */
+    void serialized(size_t bytes, size_t sections);
+    /*!
+     * The latest snapshot of `file` was written.
+     */
+    void written(const std::string & file);
+    /*!
+     * The latest snapshot of `file` could not be written. Its edits are
+     * counted apart from the latencies.
+     */
+    void failed(const std::string & file);
+
+    std::string summary() const;
+    std::string to_json() const;
+    void write() const;
+
+  private:
+    bool print = false;
+    std::string output;
+    // times of the edits not handed to the writer yet, and of those it is writing
+    std::unordered_map<std::string, std::vector<clock::time_point>> unsaved;
+    std::unordered_map<std::string, std::vector<clock::time_point>> in_flight;
+    Histogram latency_us;
+    Histogram bytes;
+    Histogram sections;
+    size_t failed_edits = 0;
+};
@@ -0,0 +1,99 @@
+#include "probe.hpp"
+
+ProgramProbe::ProgramProbe()
+{
+    dispatcher.connect(sigc::mem_fun(*this, &ProgramProbe::dispatch));
+}
+
+ProgramProbe::~ProgramProbe()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        cond.notify_one();
+        worker.join();
+    }
+}
+
+void ProgramProbe::find(const std::string & program, const slot_found & callback)
+{
+    auto it = results.find(program);
+    if (it != results.end())
+    {
+        callback(it->second);
+        return;
+    }
+
+    const bool queued = callbacks.count(program);
+    callbacks.emplace(program, callback);
+    if (queued)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(program);
+    }
+
+    if (!worker.joinable())
+    {
+        worker = std::thread(&ProgramProbe::run, this);
+    }
+
+    cond.notify_one();
+}
+
+void ProgramProbe::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        cond.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (stopping)
+        {
+            return;
+        }
+
+        std::string program = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+
+        // searches PATH in-process, unlike `command -v`
+        std::string path = Glib::find_program_in_path(program);
+
+        lock.lock();
+        finished.emplace_back(std::move(program), std::move(path));
+        dispatcher.emit();
+    }
+}
+
+void ProgramProbe::dispatch()
+{
+    std::vector<std::pair<std::string, std::string>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(ready, finished);
+    }
+
+    for (auto & [program, path] : ready)
+    {
+        results[program] = path;
+        auto range = callbacks.equal_range(program);
+        std::vector<slot_found> slots;
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            slots.push_back(std::move(it->second));
+        }
+
+        callbacks.erase(range.first, range.second);
+        for (auto & slot : slots)
+        {
+            slot(path);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <gtkmm.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*!
+ * Resolves external helper programs, like the output configurator, by
+ * searching `PATH` on a background thread. No process is spawned, and the
+ * main loop never waits for the file system.
+ */
+class ProgramProbe
+{
+  public:
+    using slot_found = sigc::slot<void, const std::string&>;
+
+    ProgramProbe();
+    ~ProgramProbe();
+
+    /*!
+     * Look up `program` and call `callback` on the main thread with its full
+     * path, or with an empty string if it is not installed. Results are
+     * remembered, so later lookups of the same program call `callback` right
+     * away.
+     */
+    void find(const std::string & program, const slot_found & callback);
+
+  private:
+    void run();
+    void dispatch();
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::string> pending;
+    std::vector<std::pair<std::string, std::string>> finished;
+    bool stopping = false;
+
+    // only accessed from the main thread
+    std::unordered_map<std::string, std::string> results;
+    std::unordered_multimap<std::string, slot_found> callbacks;
+    Glib::Dispatcher dispatcher;
+};
@@ -0,0 +1,444 @@
+#include "save.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <wayfire/config/compound-option.hpp>
+#include <wayfire/config/file.hpp>
+
+SectionSnapshot::SectionSnapshot(const std::shared_ptr<wf::config::section_t> & section) :
+    name(section->get_name())
+{
+    auto registered = section->get_registered_options();
+    options.reserve(registered.size());
+    for (const auto & option : registered)
+    {
+        if (dynamic_cast<wf::config::compound_option_t*>(option.get()))
+        {
+            options.push_back({option->get_name(), "", option->clone_option()});
+        } else
+        {
+            options.push_back({option->get_name(), option->get_value_str(), nullptr});
+        }
+    }
+}
+
+void SectionSnapshot::add_to(wf::config::config_manager_t & mgr) const
+{
+    auto section = std::make_shared<wf::config::section_t>(name);
+    for (const auto & option : options)
+    {
+        if (option.compound)
+        {
+            section->register_new_option(option.compound);
+        } else
+        {
+            section->register_new_option(
+                std::make_shared<wf::config::option_t<std::string>>(option.name, option.value));
+        }
+    }
+
+    mgr.merge_section(section);
+}
+
+SaveScheduler::SaveScheduler(const slot_save & save) : save(save)
+{}
+
+SaveScheduler::~SaveScheduler()
+{
+    // the owner flushes while the configs are still alive
+    timer.disconnect();
+}
+
+void SaveScheduler::set_delays(std::chrono::milliseconds quiet_window,
+    std::chrono::milliseconds max_latency)
+{
+    this->quiet_window = quiet_window;
+    this->max_latency  = std::max(quiet_window, max_latency);
+}
+
+void SaveScheduler::schedule(wf::config::config_manager_t & mgr, const std::string & file,
+    const std::string & section)
+{
+    const auto now = clock::now();
+    if (dirty.empty())
+    {
+        first_edit = now;
+    }
+
+    last_edit = now;
+    auto it = std::find_if(dirty.begin(), dirty.end(), [&] (const SaveRequest & request)
+    {
+        return request.mgr == &mgr;
+    });
+    if (it == dirty.end())
+    {
+        it = dirty.insert(dirty.end(), SaveRequest{&mgr, file});
+    }
+
+    if (section.empty())
+    {
+        it->whole_file = true;
+    } else
+    {
+        it->sections.insert(section);
+    }
+
+    // the timer is not restarted on every edit, on_timeout() checks for newer ones
+    if (!timer.connected())
+    {
+        arm(quiet_window);
+    }
+}
+
+void SaveScheduler::flush()
+{
+    timer.disconnect();
+    auto targets = std::move(dirty);
+    dirty.clear();
+    for (const auto & request : targets)
+    {
+        save(request);
+    }
+}
+
+void SaveScheduler::arm(clock::duration delay)
+{
+    const unsigned int ms =
+        std::max<int64_t>(1, std::chrono::ceil<std::chrono::milliseconds>(delay).count());
+    timer = Glib::signal_timeout().connect(sigc::mem_fun(*this, &SaveScheduler::on_timeout), ms);
+}
+
+bool SaveScheduler::on_timeout()
+{
+    const auto now = clock::now();
+    const auto deadline = std::min(last_edit + quiet_window, first_edit + max_latency);
+    if (now < deadline)
+    {
+        arm(deadline - now);
+        return false;
+    }
+
+    flush();
+    return false;
+}
+
+ConfigWriter::ConfigWriter()
+{
+    dispatcher.connect(sigc::mem_fun(*this, &ConfigWriter::dispatch));
+}
+
+ConfigWriter::~ConfigWriter()
+{
+    // the owner of the callbacks may already be gone
+    written_callback = slot_written();
+    logged_callback  = slot_logged();
+    finish();
+}
+
+void ConfigWriter::finish()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        cond.notify_one();
+        worker.join();
+        stopping = false;
+    }
+
+    dispatch();
+}
+
+ConfigWriter::job& ConfigWriter::enqueue(const std::string & path)
+{
+    auto [it, inserted] = jobs.try_emplace(path);
+    if (inserted)
+    {
+        queue.push_back({task::TASK_FILE, path});
+    }
+
+    return it->second;
+}
+
+void ConfigWriter::start()
+{
+    if (!worker.joinable())
+    {
+        worker = std::thread(&ConfigWriter::run, this);
+    }
+
+    cond.notify_one();
+}
+
+void ConfigWriter::load(const std::string & path, std::string contents)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        enqueue(path).base = std::move(contents);
+    }
+
+    start();
+}
+
+uint64_t ConfigWriter::save(const std::string & path, std::vector<SectionSnapshot> sections,
+    bool whole_file, uint64_t last_batch)
+{
+    uint64_t serial;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto & pending = enqueue(path);
+        if (whole_file)
+        {
+            pending.sections   = std::move(sections);
+            pending.whole_file = true;
+        } else
+        {
+            for (auto & section : sections)
+            {
+                auto it = std::find_if(pending.sections.begin(), pending.sections.end(),
+                    [&] (const SectionSnapshot & queued) { return queued.name == section.name; });
+                if (it == pending.sections.end())
+                {
+                    pending.sections.push_back(std::move(section));
+                } else
+                {
+                    *it = std::move(section);
+                }
+            }
+        }
+
+        pending.save = true;
+        pending.last_batch = last_batch;
+        pending.serial     = serial = ++last_serial;
+    }
+
+    start();
+    return serial;
+}
+
+WriteAheadLog::replay ConfigWriter::open_log(const std::string & path)
+{
+    std::lock_guard<std::mutex> lock(log_mutex);
+    auto replay = wal.open(path);
+    log_enabled = wal.is_open();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        last_batch = replay.last_batch;
+    }
+
+    return replay;
+}
+
+uint64_t ConfigWriter::log(std::vector<WriteAheadLog::record> records)
+{
+    uint64_t batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch = ++last_batch;
+        task log_task = {task::TASK_LOG};
+        log_task.batch   = batch;
+        log_task.records = std::move(records);
+        queue.push_back(std::move(log_task));
+    }
+
+    start();
+    return batch;
+}
+
+void ConfigWriter::clear_log()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({task::TASK_CLEAR_LOG});
+    }
+
+    start();
+}
+
+void ConfigWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        cond.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty())
+        {
+            // stopping, and everything is written
+            return;
+        }
+
+        task current = std::move(queue.front());
+        queue.pop_front();
+        switch (current.kind)
+        {
+          case task::TASK_FILE:
+          {
+            auto node = jobs.extract(current.path);
+            lock.unlock();
+            auto result = process(current.path, node.mapped());
+            lock.lock();
+            if (result)
+            {
+                finished.push_back(std::move(*result));
+                dispatcher.emit();
+            }
+
+            break;
+          }
+
+          case task::TASK_LOG:
+          {
+            lock.unlock();
+            const bool ok = append_log(current.batch, current.records);
+            lock.lock();
+            logged.emplace_back(current.batch, ok);
+            dispatcher.emit();
+            break;
+          }
+
+          case task::TASK_CLEAR_LOG:
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> log_lock(log_mutex);
+                wal.clear();
+            }
+
+            lock.lock();
+            break;
+        }
+    }
+}
+
+bool ConfigWriter::append_log(uint64_t batch, const std::vector<WriteAheadLog::record> & records)
+{
+    std::unordered_map<std::string, uint64_t> hashes;
+    for (const auto & rec : records)
+    {
+        auto it = disk_hashes.find(rec.file);
+        if (it != disk_hashes.end())
+        {
+            hashes.insert(*it);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(log_mutex);
+    if (!wal.is_open())
+    {
+        return false;
+    }
+
+    if (!wal.append(batch, records, hashes))
+    {
+        // the tail of the log may be torn now, do not append after it
+        wal.close();
+        return false;
+    }
+
+    return true;
+}
+
+std::optional<ConfigWriter::write_result> ConfigWriter::process(const std::string & path,
+    job & job)
+{
+    auto & ini = files[path];
+    if (job.base)
+    {
+        ini.parse(*job.base);
+        disk_hashes[path] = WriteAheadLog::hash(*job.base);
+        std::lock_guard<std::mutex> lock(log_mutex);
+        wal.loaded(path, disk_hashes[path]);
+    }
+
+    if (!job.save)
+    {
+        return {};
+    }
+
+    write_result result = {path, job.serial, "", job.sections.size(), WRITE_OK};
+    if (job.whole_file)
+    {
+        wf::config::config_manager_t mgr;
+        for (const auto & section : job.sections)
+        {
+            section.add_to(mgr);
+        }
+
+        result.contents = wf::config::save_configuration_options_to_string(mgr);
+        ini.parse(result.contents);
+    } else if (!ini.valid())
+    {
+        result.status = WRITE_NEEDS_FILE;
+        return result;
+    } else
+    {
+        for (const auto & section : job.sections)
+        {
+            wf::config::config_manager_t single;
+            section.add_to(single);
+            if (ini.update_section(wf::config::save_configuration_options_to_string(single)) < 0)
+            {
+                result.status = WRITE_NEEDS_FILE;
+                return result;
+            }
+        }
+
+        result.contents = ini.str();
+    }
+
+    // replace the target of a symlink, such as a config kept in a dotfiles repository
+    std::error_code ec;
+    std::string target = path;
+    if (std::filesystem::is_symlink(path, ec))
+    {
+        auto resolved = std::filesystem::weakly_canonical(path, ec);
+        if (!ec)
+        {
+            target = resolved;
+        }
+    }
+
+    if (!write_file_atomic(target, result.contents))
+    {
+        std::cerr << "Failed to write " << target << std::endl;
+        result.status = WRITE_FAILED;
+        return result;
+    }
+
+    disk_hashes[path] = WriteAheadLog::hash(result.contents);
+    std::lock_guard<std::mutex> lock(log_mutex);
+    wal.written(path, disk_hashes[path], job.last_batch);
+    return result;
+}
+
+void ConfigWriter::dispatch()
+{
+    std::vector<std::pair<uint64_t, bool>> batches;
+    std::vector<write_result> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(batches, logged);
+        std::swap(ready, finished);
+    }
+
+    for (const auto & [batch, ok] : batches)
+    {
+        log_enabled &= ok;
+        if (logged_callback)
+        {
+            logged_callback(batch, ok);
+        }
+    }
+
+    for (const auto & result : ready)
+    {
+        if (written_callback)
+        {
+            written_callback(result);
+        }
+    }
+}
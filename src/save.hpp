@@ -0,0 +1,297 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <gtkmm.h>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <wayfire/config/config-manager.hpp>
+
+#include "changes.hpp"
+#include "ini.hpp"
+
+/*!
+ * The options of a config section as (name, value) pairs, taken on the main
+ * thread so that the writer thread can serialize them while the config keeps
+ * changing.
+ */
+struct SectionSnapshot
+{
+    struct option_value
+    {
+        std::string name;
+        std::string value;
+        // copy of a compound option, which is saved as the list of its entries
+        std::shared_ptr<wf::config::option_base_t> compound;
+    };
+
+    explicit SectionSnapshot(const std::shared_ptr<wf::config::section_t> & section);
+
+    /*!
+     * Add the section, with options holding the snapshot values, to `mgr`.
+     * Safe to call from any thread.
+     */
+    void add_to(wf::config::config_manager_t & mgr) const;
+
+    std::string name;
+    std::vector<option_value> options;
+};
+
+/*!
+ * The changes of one config file that a flush has to write.
+ */
+struct SaveRequest
+{
+    wf::config::config_manager_t *mgr;
+    std::string file;
+    // sections that changed, only meaningful if `whole_file` is not set
+    std::set<std::string> sections;
+    bool whole_file = false;
+};
+
+/*!
+ * Write-behind saving of the config files. Edits only mark their config
+ * manager dirty, and the dirty configs are written once no edit came in for
+ * the quiet window, or once the oldest unsaved edit reaches the maximum
+ * latency, whichever comes first. A spin button held down or a color drag
+ * thus ends up as a single write instead of one per step.
+ */
+class SaveScheduler
+{
+  public:
+    using clock     = std::chrono::steady_clock;
+    using slot_save = sigc::slot<void, const SaveRequest&>;
+
+    static constexpr std::chrono::milliseconds DEFAULT_QUIET_WINDOW{150};
+    static constexpr std::chrono::milliseconds DEFAULT_MAX_LATENCY{1000};
+
+    /*!
+     * `save` is called on the main thread for every dirty config when it is
+     * flushed.
+     */
+    explicit SaveScheduler(const slot_save & save);
+    ~SaveScheduler();
+
+    SaveScheduler(const SaveScheduler &) = delete;
+    SaveScheduler& operator =(const SaveScheduler &) = delete;
+
+    /*!
+     * Change the delays. The maximum latency is raised to the quiet window if
+     * it is shorter.
+     */
+    void set_delays(std::chrono::milliseconds quiet_window,
+        std::chrono::milliseconds max_latency);
+
+    /*!
+     * Mark `section` of `mgr` as changed, to be written to `file` later. An
+     * empty `section` means the whole config may have changed.
+     */
+    void schedule(wf::config::config_manager_t & mgr, const std::string & file,
+        const std::string & section = "");
+    /*!
+     * Write all dirty configs right away.
+     */
+    void flush();
+
+    inline bool pending() const
+    {
+        return !dirty.empty();
+    }
+
+  private:
+    bool on_timeout();
+    void arm(clock::duration delay);
+
+    slot_save save;
+    std::chrono::milliseconds quiet_window = DEFAULT_QUIET_WINDOW;
+    std::chrono::milliseconds max_latency  = DEFAULT_MAX_LATENCY;
+    std::vector<SaveRequest> dirty;
+    clock::time_point first_edit;
+    clock::time_point last_edit;
+    sigc::connection timer;
+};
+
+/*!
+ * Writes config files on a background thread, so the main loop never waits
+ * for the disk. Files are replaced atomically with write_file_atomic(), so
+ * Wayfire never reads a half-written config.
+ *
+ * The main thread only hands over snapshots of the changed sections. The
+ * writer thread serializes them and patches them into its line index of the
+ * file, so comments and the order of the file are kept. The file is still
+ * written and synced as a whole on every save. Saves of a file which were not
+ * written yet are merged, the newest snapshot of a section wins.
+ *
+ * The writer also appends the transactions to the write-ahead log, in order
+ * with the saves, and notes each load and write of a file in it.
+ */
+class ConfigWriter
+{
+  public:
+    enum write_status
+    {
+        WRITE_OK,
+        WRITE_FAILED,
+        // the sections could not be patched into the file, save the whole file
+        WRITE_NEEDS_FILE,
+    };
+
+    struct write_result
+    {
+        std::string path;
+        // serial of the newest save merged into this write
+        uint64_t serial;
+        std::string contents;
+        size_t sections;
+        write_status status;
+    };
+
+    /*!
+     * Called on the main thread after each write. Files only indexed with
+     * load() are not reported.
+     */
+    using slot_written = sigc::slot<void, const write_result&>;
+    /*!
+     * Called on the main thread once a batch of the log is on disk, with
+     * whether it could be logged.
+     */
+    using slot_logged = sigc::slot<void, uint64_t, bool>;
+
+    ConfigWriter();
+    /*!
+     * Waits until the queued saves are written, without reporting them.
+     */
+    ~ConfigWriter();
+
+    ConfigWriter(const ConfigWriter &) = delete;
+    ConfigWriter& operator =(const ConfigWriter &) = delete;
+
+    /*!
+     * Index `contents` as the current contents of `path`, which the next
+     * saves are patched into.
+     */
+    void load(const std::string & path, std::string contents);
+    /*!
+     * Queue `sections` to be saved to `path`. If `whole_file` is set they are
+     * all the sections of the file, which is then written from scratch.
+     * `last_batch` is the last log batch whose changes to `path` the
+     * sections hold. Returns the serial of the save, which is reported once
+     * written.
+     *
+     * If `path` is a symlink, the file it points to is replaced and the link
+     * is kept.
+     */
+    uint64_t save(const std::string & path, std::vector<SectionSnapshot> sections,
+        bool whole_file, uint64_t last_batch);
+
+    /*!
+     * Open the write-ahead log at `path` and return what a previous run left
+     * in it.
+     */
+    WriteAheadLog::replay open_log(const std::string & path);
+
+    /*!
+     * False until the log is opened, and once logging failed.
+     */
+    inline bool logging() const
+    {
+        return log_enabled;
+    }
+
+    /*!
+     * Append `records`, the changes of one transaction, to the log after the
+     * saves queued so far. Returns the number of the batch, which is reported
+     * once it is on disk.
+     */
+    uint64_t log(std::vector<WriteAheadLog::record> records);
+    /*!
+     * Empty the log, once the saves queued so far are written.
+     */
+    void clear_log();
+
+    inline void set_written_callback(const slot_written & callback)
+    {
+        written_callback = callback;
+    }
+
+    inline void set_logged_callback(const slot_logged & callback)
+    {
+        logged_callback = callback;
+    }
+
+    /*!
+     * Write the queued saves and report them before returning, for when
+     * the main loop no longer runs.
+     */
+    void finish();
+
+  private:
+    struct job
+    {
+        uint64_t serial = 0;
+        uint64_t last_batch = 0;
+        // contents to index before saving
+        std::optional<std::string> base;
+        std::vector<SectionSnapshot> sections;
+        bool whole_file = false;
+        bool save = false;
+    };
+
+    struct task
+    {
+        enum kind_t
+        {
+            TASK_FILE,
+            TASK_LOG,
+            TASK_CLEAR_LOG,
+        };
+
+        kind_t kind;
+        // TASK_FILE
+        std::string path;
+        // TASK_LOG
+        uint64_t batch = 0;
+        std::vector<WriteAheadLog::record> records;
+    };
+
+    job& enqueue(const std::string & path);
+    void start();
+    void run();
+    std::optional<write_result> process(const std::string & path, job & job);
+    bool append_log(uint64_t batch, const std::vector<WriteAheadLog::record> & records);
+    void dispatch();
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cond;
+    // tasks in the order they were queued, a file is in it once and its
+    // saves are merged into its job
+    std::deque<task> queue;
+    std::unordered_map<std::string, job> jobs;
+    std::vector<write_result> finished;
+    std::vector<std::pair<uint64_t, bool>> logged;
+    uint64_t last_serial = 0;
+    uint64_t last_batch  = 0;
+    bool stopping = false;
+
+    // used by the worker thread, and by open_log() before anything is logged
+    std::mutex log_mutex;
+    WriteAheadLog wal;
+    // line index and hash of each file as it is on disk, worker thread only
+    std::unordered_map<std::string, IniFile> files;
+    std::unordered_map<std::string, uint64_t> disk_hashes;
+    // main thread only
+    bool log_enabled = false;
+
+    slot_written written_callback;
+    slot_logged logged_callback;
+    Glib::Dispatcher dispatcher;
+};
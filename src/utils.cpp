@@ -1,5 +1,15 @@
 #include "utils.hpp"
 #include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
 
 #include <xkbcommon/xkbregistry.h>
 
@@ -19,50 +29,197 @@ bool find_string(std::string text, std::string pattern)
 bool begins_with(const std::string & str, const std::string & prefix)
 {
     return prefix.length() <= str.length() &&
-           str.substr(0, prefix.length()) == prefix;
+           str.compare(0, prefix.length(), prefix) == 0;
 }
 
 using rxkb_context_ptr = std::unique_ptr<rxkb_context, decltype(&rxkb_context_unref)>;
 
-std::map<std::string, std::string> get_xkb_layouts(const std::string& ruleset)
+static XkbRegistry load_xkb_registry(const std::string & ruleset)
 {
+    XkbRegistry registry;
     rxkb_context_ptr context =
     {rxkb_context_new(rxkb_context_flags::RXKB_CONTEXT_NO_FLAGS), &rxkb_context_unref};
     if (!rxkb_context_parse(context.get(), ruleset.c_str()))
     {
-        return {};
+        return registry;
     }
 
-    std::map<std::string, std::string> layouts;
     for (rxkb_layout *layout = rxkb_layout_first(context.get());
          layout != nullptr;
          layout = rxkb_layout_next(layout))
     {
-        if (rxkb_layout_get_variant(layout) == nullptr)
+        const char *description = rxkb_layout_get_description(layout);
+        if (const char *variant = rxkb_layout_get_variant(layout))
         {
-            layouts.emplace(rxkb_layout_get_name(layout), rxkb_layout_get_description(layout));
+            registry.variants[rxkb_layout_get_name(layout)].emplace(variant,
+                description ? description : "");
+        } else
+        {
+            registry.layouts.emplace(rxkb_layout_get_name(layout), description ? description : "");
         }
     }
 
-    return layouts;
+    for (rxkb_model *model = rxkb_model_first(context.get());
+         model != nullptr;
+         model = rxkb_model_next(model))
+    {
+        const char *description = rxkb_model_get_description(model);
+        registry.models.emplace(rxkb_model_get_name(model), description ? description : "");
+    }
+
+    return registry;
 }
 
-std::map<std::string, std::string> get_xkb_models(const std::string& ruleset)
+std::shared_future<XkbRegistry> get_xkb_registry(const std::string & ruleset)
 {
-    rxkb_context_ptr context =
-    {rxkb_context_new(rxkb_context_flags::RXKB_CONTEXT_NO_FLAGS), &rxkb_context_unref};
-    if (!rxkb_context_parse(context.get(), ruleset.c_str()))
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_future<XkbRegistry>> registries;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = registries.find(ruleset);
+    if (it == registries.end())
     {
-        return {};
+        it = registries.emplace(ruleset,
+            std::async(std::launch::async, load_xkb_registry, ruleset).share()).first;
     }
 
-    std::map<std::string, std::string> models;
-    for (rxkb_model *model = rxkb_model_first(context.get());
-         model != nullptr;
-         model = rxkb_model_next(model))
+    return it->second;
+}
+
+std::string get_xdg_dir(const char *env, const std::string & fallback)
+{
+    std::string dir;
+    if (const char *c_dir = std::getenv(env); c_dir && *c_dir)
+    {
+        dir = c_dir;
+    } else if (const char *c_home = std::getenv("HOME"))
+    {
+        dir = std::string(c_home) + "/" + fallback;
+    }
+
+    while ((dir.size() > 1) && (dir.back() == '/'))
+    {
+        dir.pop_back();
+    }
+
+    return dir;
+}
+
+std::optional<std::string> read_file(const std::string & path)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec) || ec)
+        {
+            return {};
+        }
+
+        return std::string();
+    }
+
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+bool write_file_atomic(const std::string & path, const std::string & contents)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    std::string tmp_path = path + ".XXXXXX";
+    int fd = mkstemp(tmp_path.data());
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // mkstemp() creates the file private, keep the mode of the file we replace
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+    {
+        fchmod(fd, st.st_mode & 07777);
+    }
+
+    const char *buf = contents.data();
+    size_t left     = contents.size();
+    while (left > 0)
+    {
+        ssize_t written = write(fd, buf, left);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        buf  += written;
+        left -= written;
+    }
+
+    bool ok = (left == 0) && (fsync(fd) == 0);
+    ok &= (close(fd) == 0);
+    if (!ok || (rename(tmp_path.c_str(), path.c_str()) != 0))
+    {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+MappedFile::MappedFile(const std::string & path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
     {
-        models.emplace(rxkb_model_get_name(model), rxkb_model_get_description(model));
+        return;
     }
 
-    return models;
+    struct stat st;
+    if ((fstat(fd, &st) == 0) && (st.st_size > 0))
+    {
+        void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            ptr    = (const char*)addr;
+            length = st.st_size;
+        }
+    }
+
+    close(fd);
+}
+
+MappedFile::MappedFile(MappedFile && other)
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator =(MappedFile && other)
+{
+    if (this != &other)
+    {
+        if (ptr)
+        {
+            munmap((void*)ptr, length);
+        }
+
+        ptr    = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    if (ptr)
+    {
+        munmap((void*)ptr, length);
+    }
 }
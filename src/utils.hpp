@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <gtkmm.h>
+#include <map>
+#include <optional>
 #include <string>
+#include <thread>
 #include <wayfire/config/section.hpp>
 
 using wf_section = std::shared_ptr<wf::config::section_t>;
@@ -14,8 +20,108 @@ bool find_string(std::string text, std::string pattern);
 
 bool begins_with(const std::string & str, const std::string & prefix);
 
-std::map<std::string, std::string> get_xkb_layouts(const std::string& ruleset);
-std::map<std::string, std::string> get_xkb_models(const std::string& ruleset);
+/*!
+ * Layouts, variants and models of an XKB ruleset, each mapped to its
+ * description. Variants are grouped by layout.
+ */
+struct XkbRegistry
+{
+    std::map<std::string, std::string> layouts;
+    std::map<std::string, std::map<std::string, std::string>> variants;
+    std::map<std::string, std::string> models;
+};
+
+/*!
+ * Returns the registry of `ruleset`. The rules are parsed only once per
+ * process, on a background thread started by the first call, and the result
+ * is shared by all callers.
+ */
+std::shared_future<XkbRegistry> get_xkb_registry(const std::string & ruleset);
+
+/*!
+ * Returns the directory named by the XDG environment variable `env`, or
+ * `$HOME/fallback` when it is unset. The result has no trailing slash.
+ */
+std::string get_xdg_dir(const char *env, const std::string & fallback);
+
+/*!
+ * Returns the contents of the file at `path`. A file which does not exist is
+ * empty, nothing is returned if the file exists but cannot be read.
+ */
+std::optional<std::string> read_file(const std::string & path);
+
+/*!
+ * Write `contents` to a temporary file next to `path`, fsync it and rename it
+ * over `path`, so that readers never observe a partially written file. The
+ * new file keeps the permissions of the old one.
+ */
+bool write_file_atomic(const std::string & path, const std::string & contents);
+
+/*!
+ * Call `func(i)` for every `i` in `[0, count)` on a pool of worker threads,
+ * one per core. The calling thread takes part in the work and the function
+ * returns once all calls have finished.
+ */
+template<class Func>
+void parallel_for(size_t count, Func func)
+{
+    size_t num_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::atomic<size_t> next = 0;
+    auto worker = [&]
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            func(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/*!
+ * Read-only memory mapping of a whole file. The mapping is released when the
+ * object is destroyed.
+ */
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string & path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator =(const MappedFile &) = delete;
+    MappedFile(MappedFile && other);
+    MappedFile& operator =(MappedFile && other);
+    ~MappedFile();
+
+    inline const char *data() const
+    {
+        return ptr;
+    }
+
+    inline size_t size() const
+    {
+        return length;
+    }
+
+    inline explicit operator bool() const
+    {
+        return ptr != nullptr;
+    }
+
+  private:
+    const char *ptr = nullptr;
+    size_t length   = 0;
+};
 
 /*!
  * Button with text and icon.
@@ -0,0 +1,116 @@
+#include "watch.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+ConfigWatcher::ConfigWatcher(const slot_changed & changed) : changed(changed)
+{}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    io_connection.disconnect();
+    settle_timer.disconnect();
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+bool ConfigWatcher::watch(const std::string & path)
+{
+    if (fd < 0)
+    {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+        {
+            std::cerr << "Failed to watch config files: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        io_connection = Glib::signal_io().connect(
+            sigc::mem_fun(*this, &ConfigWatcher::on_io), fd, Glib::IO_IN);
+    }
+
+    bool ok = add_watch(path, path);
+    std::error_code ec;
+    if (std::filesystem::is_symlink(path, ec))
+    {
+        auto target = std::filesystem::weakly_canonical(path, ec);
+        if (!ec)
+        {
+            ok &= add_watch(target, path);
+        }
+    }
+
+    return ok;
+}
+
+bool ConfigWatcher::add_watch(const std::string & file, const std::string & path)
+{
+    std::filesystem::path file_path(file);
+    auto dir = file_path.parent_path();
+    if (dir.empty())
+    {
+        dir = ".";
+    }
+
+    // a directory watched twice keeps its descriptor
+    int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0)
+    {
+        std::cerr << "Failed to watch " << dir << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    files[{wd, file_path.filename().string()}] = path;
+    return true;
+}
+
+bool ConfigWatcher::on_io(Glib::IOCondition condition)
+{
+    alignas(inotify_event) char buf[4096];
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0)
+    {
+        for (char *ptr = buf; ptr < buf + len;)
+        {
+            auto *event = (inotify_event*)ptr;
+            ptr += sizeof(inotify_event) + event->len;
+            if (event->len == 0)
+            {
+                continue;
+            }
+
+            auto it = files.find({event->wd, event->name});
+            if (it != files.end())
+            {
+                modified.insert(it->second);
+            }
+        }
+    }
+
+    if (!modified.empty())
+    {
+        settle_timer.disconnect();
+        settle_timer = Glib::signal_timeout().connect(
+            sigc::mem_fun(*this, &ConfigWatcher::on_settled), SETTLE_DELAY.count());
+    }
+
+    return true;
+}
+
+bool ConfigWatcher::on_settled()
+{
+    auto paths = std::move(modified);
+    modified.clear();
+    for (const auto & path : paths)
+    {
+        changed(path);
+    }
+
+    return false;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <gtkmm.h>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+/*!
+ * Watches config files for modifications with inotify, from the main loop.
+ *
+ * The directories of the files are watched rather than the files, because
+ * editors and WCM itself replace a file by renaming a new one over it. If a
+ * file is a symlink, the directory of its target is watched as well.
+ */
+class ConfigWatcher
+{
+  public:
+    using slot_changed = sigc::slot<void, const std::string&>;
+
+    // editors write in several steps, wait for them to finish
+    static constexpr std::chrono::milliseconds SETTLE_DELAY{100};
+
+    /*!
+     * `changed` is called on the main thread with the path given to watch(),
+     * once the file was modified and no more modifications came in for
+     * SETTLE_DELAY.
+     */
+    explicit ConfigWatcher(const slot_changed & changed);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher &) = delete;
+    ConfigWatcher& operator =(const ConfigWatcher &) = delete;
+
+    bool watch(const std::string & path);
+
+  private:
+    bool add_watch(const std::string & file, const std::string & path);
+    bool on_io(Glib::IOCondition condition);
+    bool on_settled();
+
+    slot_changed changed;
+    int fd = -1;
+    sigc::connection io_connection;
+    sigc::connection settle_timer;
+    // (watch descriptor, file name) -> path given to watch()
+    std::map<std::pair<int, std::string>, std::string> files;
+    std::set<std::string> modified;
+};
@@ -1,8 +1,8 @@
 #include "wcm.hpp"
 #include "utils.hpp"
 
-#include <filesystem>
 #include <fmt/core.h>
+#include <future>
 #include <libevdev/libevdev.h>
 #include <libintl.h>
 #include <wayfire/config/compound-option.hpp>
@@ -15,6 +15,7 @@
 #define OUTPUT_CONFIG_PROGRAM "wdisplays"
 
 constexpr int OPTION_LABEL_SIZE = 200;
+constexpr int PLUGIN_LABEL_WIDTH_CHARS = 20;
 
 bool KeyEntry::check_and_confirm(const std::string & key_str)
 {
@@ -244,7 +245,8 @@ static void add_comma_with_space(Glib::ustring& text)
 
 LayoutsEntry::LayoutsEntry()
 {
-    for (const auto & [name, description] : get_xkb_layouts(WCM::get_instance()->get_xkb_rules()))
+    const auto & registry = get_xkb_registry(WCM::get_instance()->get_xkb_rules()).get();
+    for (const auto & [name, description] : registry.layouts)
     {
         layouts.emplace_back(name + " — " + description);
         layouts.back().signal_activate().connect([name = name, this] ()
@@ -271,7 +273,8 @@ LayoutsEntry::LayoutsEntry()
 
 XkbModelEntry::XkbModelEntry()
 {
-    for (const auto & [name, description] : get_xkb_models(WCM::get_instance()->get_xkb_rules()))
+    const auto & registry = get_xkb_registry(WCM::get_instance()->get_xkb_rules()).get();
+    for (const auto & [name, description] : registry.models)
     {
         models.emplace_back(name + " — " + description);
         models.back().signal_activate().connect([name = name, this] ()
@@ -304,8 +307,7 @@ template<class value_type>
 void Option::set_value(wf_section section, const value_type & value)
 {
     std::cout << section->get_name() << "." << name << " = " << value << "; ";
-    section->get_option(name)->set_value_str(wf::option_type::to_string<value_type>(
-        value));
+    WCM::get_instance()->set_option(section, name, wf::option_type::to_string<value_type>(value));
     std::cout << section->get_option(name)->get_value_str() << "; ";
 }
 
@@ -320,7 +322,6 @@ void Option::set_save(const ArgTypes &... args)
 
     std::cout << __PRETTY_FUNCTION__ << ": \n  ";
     set_value(section, args...);
-    WCM::get_instance()->save_config(plugin);
 }
 
 static void update_int_sb_option_value(GtkSpinButton *spin_button, Option *option)
@@ -342,6 +343,7 @@ static void update_animate_cb_option_value(GtkComboBoxText *combo_box, animate_o
 
 OptionWidget::~OptionWidget()
 {
+    WCM::get_instance()->remove_option_widget(config_option.get(), this);
     if (int_spin_button)
     {
         g_signal_handler_disconnect(int_spin_button->gobj(), int_sb_handle);
@@ -361,8 +363,8 @@ OptionWidget::~OptionWidget()
 OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTAL,
         10)
 {
-    name_label.set_text(option->disp_name);
-    name_label.set_tooltip_markup(option->tooltip);
+    name_label.set_text(option->disp_name.str());
+    name_label.set_tooltip_markup(option->tooltip.str());
     name_label.set_size_request(OPTION_LABEL_SIZE);
     name_label.set_alignment(Gtk::ALIGN_START);
 
@@ -374,17 +376,18 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
 
     auto section   = WCM::get_instance()->get_config_section(option->plugin);
     auto wf_option = section->get_option(option->name);
+    config_option  = wf_option;
 
-    switch (option->type)
+    switch (option->type())
     {
       case OPTION_TYPE_INT:
     {
         int value = wf::option_type::from_string<int>(wf_option->get_value_str()).value_or(
-            std::get<int>(option->default_value));
-        if (option->int_labels.empty())
+            option->default_int());
+        if (option->int_labels().empty())
         {
             int_spin_button = std::make_unique<Gtk::SpinButton>(
-                Gtk::Adjustment::create(value, option->data.min, option->data.max,
+                Gtk::Adjustment::create(value, option->get_data().min, option->get_data().max,
                     1));
             int_sb_handle =
                 g_signal_connect(int_spin_button->gobj(), "value-changed", G_CALLBACK(
@@ -392,23 +395,30 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
             reset_button.signal_clicked().connect(
                 [=, widget = int_spin_button.get()]
                 {
-                    widget->set_value(std::get<int>(option->default_value));
+                    widget->set_value(option->default_int());
                 });
+            value_setter = [widget = int_spin_button.get()] (const std::string & value)
+            {
+                if (auto int_value = wf::option_type::from_string<int>(value))
+                {
+                    widget->set_value(*int_value);
+                }
+            };
             pack_end(std::move(int_spin_button));
         } else
         {
             auto combo_box = std::make_unique<Gtk::ComboBoxText>();
-            for (const auto & [name, _] : option->int_labels)
+            for (const auto & [name, _] : option->int_labels())
             {
-                combo_box->append(name);
+                combo_box->append(name.str());
             }
 
             combo_box->set_active(value);
             combo_box->signal_changed().connect([=, widget = combo_box.get()]
                 {
-                    for (const auto & [name, int_value] : option->int_labels)
+                    for (const auto & [name, int_value] : option->int_labels())
                     {
-                        if (name == widget->get_active_text())
+                        if (name.str() == widget->get_active_text())
                         {
                             option->set_save(int_value);
                         }
@@ -417,8 +427,15 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
             reset_button.signal_clicked().connect(
                 [=, widget = combo_box.get()]
                 {
-                    widget->set_active(std::get<int>(option->default_value));
+                    widget->set_active(option->default_int());
                 });
+            value_setter = [widget = combo_box.get()] (const std::string & value)
+            {
+                if (auto int_value = wf::option_type::from_string<int>(value))
+                {
+                    widget->set_active(*int_value);
+                }
+            };
             pack_end(std::move(combo_box), true, true);
         }
     }
@@ -429,13 +446,12 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
         auto set_value = wf::option_type::from_string<wf::animation_description_t>(
             wf_option->get_value_str());
         auto default_value =
-            wf::option_type::from_string<wf::animation_description_t>(std::get<std::string>(option->
-                default_value));
+            wf::option_type::from_string<wf::animation_description_t>(option->default_string());
         int length_value = set_value ? set_value->length_ms : default_value->length_ms;
         std::string easing_value = set_value ? set_value->easing_name : default_value->easing_name;
 
         animate_spin_button = std::make_unique<Gtk::SpinButton>(
-            Gtk::Adjustment::create(length_value, option->data.min, option->data.max, 1));
+            Gtk::Adjustment::create(length_value, option->get_data().min, option->get_data().max, 1));
         animate_combo_box = std::make_unique<Gtk::ComboBoxText>();
         for (const auto& easing : wf::animation::smoothing::get_available_smooth_functions())
         {
@@ -472,6 +488,15 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
                 length_widget->set_value(default_value->length_ms);
                 easing_widget->set_active_text(default_value->easing_name);
             });
+        value_setter = [length_widget = animate_spin_button.get(),
+                        easing_widget = animate_combo_box.get()] (const std::string & value)
+        {
+            if (auto animation = wf::option_type::from_string<wf::animation_description_t>(value))
+            {
+                length_widget->set_value(animation->length_ms);
+                easing_widget->set_active_text(animation->easing_name);
+            }
+        };
         pack_end(std::move(animate_spin_button));
         pack_end(std::move(animate_combo_box));
     }
@@ -481,8 +506,7 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
     {
         auto value_optional = wf::option_type::from_string<bool>(
             wf_option->get_value_str());
-        bool value = value_optional ? value_optional.value() : std::get<int>(
-            option->default_value);
+        bool value = value_optional ? value_optional.value() : option->default_int();
 
         auto check_button = std::make_unique<Gtk::CheckButton>();
         check_button->set_active(value);
@@ -494,8 +518,15 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
         reset_button.signal_clicked().connect(
             [=, widget = check_button.get()]
             {
-                widget->set_active(std::get<int>(option->default_value));
+                widget->set_active(option->default_int());
             });
+        value_setter = [widget = check_button.get()] (const std::string & value)
+        {
+            if (auto bool_value = wf::option_type::from_string<bool>(value))
+            {
+                widget->set_active(*bool_value);
+            }
+        };
         pack_end(std::move(check_button));
     }
     break;
@@ -504,13 +535,12 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
     {
         auto value_optional = wf::option_type::from_string<double>(
             wf_option->get_value_str());
-        double value = value_optional ? value_optional.value() : std::get<double>(
-            option->default_value);
+        double value = value_optional ? value_optional.value() : option->default_double();
 
         auto spin_box = std::make_unique<Gtk::SpinButton>(
-            Gtk::Adjustment::create(value, option->data.min, option->data.max,
-                option->data.precision),
-            option->data.precision, 3);
+            Gtk::Adjustment::create(value, option->get_data().min, option->get_data().max,
+                option->get_data().precision),
+            option->get_data().precision, 3);
         spin_box->signal_changed().connect(sigc::track_obj([=, widget = spin_box.get()]
             {
                 option->set_save(widget->get_value());
@@ -518,8 +548,15 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
         reset_button.signal_clicked().connect(
             [=, widget = spin_box.get()]
             {
-                widget->set_value(std::get<double>(option->default_value));
+                widget->set_value(option->default_double());
             });
+        value_setter = [widget = spin_box.get()] (const std::string & value)
+        {
+            if (auto double_value = wf::option_type::from_string<double>(value))
+            {
+                widget->set_value(*double_value);
+            }
+        };
         pack_end(std::move(spin_box));
     }
     break;
@@ -538,8 +575,12 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
         reset_button.signal_clicked().connect(
             [=, widget = key_entry.get()]
             {
-                widget->set_value(std::get<std::string>(option->default_value));
+                widget->set_value(option->default_string());
             });
+        value_setter = [widget = key_entry.get()] (const std::string & value)
+        {
+            widget->set_value(value);
+        };
         pack_end(std::move(key_entry), true, true);
     }
     break;
@@ -547,7 +588,7 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
       case OPTION_TYPE_GESTURE:
       case OPTION_TYPE_STRING:
     {
-        if (option->str_labels.empty())
+        if (option->str_labels().empty())
         {
             std::unique_ptr<Gtk::Entry> entry;
             if (option->name == "xkb_layout")
@@ -580,7 +621,7 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
                         widget->set_text(dialog.get_filename());
                     }
                 };
-            if (option->data.hints & HINT_DIRECTORY)
+            if (option->get_data().hints & HINT_DIRECTORY)
             {
                 auto dir_choose_button = std::make_unique<Gtk::Button>();
                 dir_choose_button->set_image_from_icon_name("folder-open");
@@ -594,7 +635,7 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
                 pack_end(std::move(dir_choose_button));
             }
 
-            if (option->data.hints & HINT_FILE)
+            if (option->get_data().hints & HINT_FILE)
             {
                 auto file_choose_button = std::make_unique<Gtk::Button>();
                 file_choose_button->set_image_from_icon_name("text-x-generic");
@@ -610,18 +651,22 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
             reset_button.signal_clicked().connect(
                 [=, widget = entry.get()]
                 {
-                    widget->set_text(std::get<std::string>(option->default_value));
+                    widget->set_text(option->default_string());
                 });
+            value_setter = [widget = entry.get()] (const std::string & value)
+            {
+                widget->set_text(value);
+            };
             pack_end(std::move(entry), true, true);
         } else
         {
             auto combo_box = std::make_unique<Gtk::ComboBoxText>();
-            for (const auto & [name, str_value] : option->str_labels)
+            for (const auto & [name, str_value] : option->str_labels())
             {
-                combo_box->append(str_value, name);
+                combo_box->append(str_value.str(), name.str());
                 if (str_value == wf_option->get_value_str())
                 {
-                    combo_box->set_active_id(str_value);
+                    combo_box->set_active_id(str_value.str());
                 }
             }
 
@@ -635,6 +680,10 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
                 {
                     widget->set_active_id(wf_option->get_default_value_str());
                 });
+            value_setter = [widget = combo_box.get()] (const std::string & value)
+            {
+                widget->set_active_id(value);
+            };
             pack_end(std::move(combo_box), true, true);
         }
     }
@@ -647,14 +696,13 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
         wf::color_t value =
             value_optional ?
             value_optional.value() :
-            wf::option_type::from_string<wf::color_t>(std::get<std::string>(option->
-                default_value)).value();
+            wf::option_type::from_string<wf::color_t>(option->default_string()).value();
 
         Gdk::RGBA rgba;
         rgba.set_rgba(value.r, value.g, value.b, value.a);
         auto color_button = std::make_unique<Gtk::ColorButton>(rgba);
         color_button->set_use_alpha(true);
-        color_button->set_title(option->disp_name);
+        color_button->set_title(option->disp_name.str());
         color_button->property_rgba().signal_changed().connect([=,
                                                                 widget =
                                                                     color_button.get()]
@@ -667,12 +715,20 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
         reset_button.signal_clicked().connect([=, widget = color_button.get()]
             {
                 auto color =
-                    wf::option_type::from_string<wf::color_t>(std::get<std::string>(
-                        option->default_value)).value();
+                    wf::option_type::from_string<wf::color_t>(option->default_string()).value();
                 Gdk::RGBA rgba;
                 rgba.set_rgba(color.r, color.g, color.b, color.a);
                 widget->set_rgba(rgba);
             });
+        value_setter = [widget = color_button.get()] (const std::string & value)
+        {
+            if (auto color = wf::option_type::from_string<wf::color_t>(value))
+            {
+                Gdk::RGBA rgba;
+                rgba.set_rgba(color->r, color->g, color->b, color->a);
+                widget->set_rgba(rgba);
+            }
+        };
         pack_end(std::move(color_button));
     }
     break;
@@ -680,12 +736,22 @@ OptionWidget::OptionWidget(Option *option) : Gtk::Box(Gtk::ORIENTATION_HORIZONTA
       default:
         break;
     }
+
+    WCM::get_instance()->add_option_widget(config_option.get(), this);
+}
+
+void OptionWidget::show_value(const std::string & value)
+{
+    if (value_setter)
+    {
+        value_setter(value);
+    }
 }
 
 AutostartDynamicList::AutostartWidget::AutostartWidget(Option *option) : Gtk::Box(
         Gtk::ORIENTATION_HORIZONTAL, 10)
 {
-    command_entry.set_text(std::get<std::string>(option->default_value));
+    command_entry.set_text(option->default_string());
     command_entry.signal_changed().connect([=]
     {
         option->set_save<std::string>(command_entry.get_text());
@@ -713,9 +779,8 @@ AutostartDynamicList::AutostartWidget::AutostartWidget(Option *option) : Gtk::Bo
     remove_button.signal_clicked().connect([=]
     {
         auto section = WCM::get_instance()->get_config_section(option->plugin);
-        section->unregister_option(section->get_option(option->name));
-        WCM::get_instance()->save_config(option->plugin);
-        delete option;
+        WCM::get_instance()->unregister_option(section, section->get_option(option->name));
+        option->parent->remove_child(option);
         ((AutostartDynamicList*)get_parent())->remove(this);
     });
     pack_start(command_entry, true, true);
@@ -777,14 +842,16 @@ BindingsDynamicList::BindingWidget::BindingWidget(const std::string & cmd_name,
     type_combo_box.set_active(always_opt ? 2 : repeatable_opt ? 1 : 0);
     type_combo_box.signal_changed().connect([=]
     {
-        section->unregister_option(binding_wf_opt);
+        auto *wcm = WCM::get_instance();
+        wcm->begin();
+        wcm->unregister_option(section, binding_wf_opt);
         auto type = type_combo_box.get_active_row_number();
         key_option->name = type == 2 ? always_binding_name : type == 1 ? repeat_binding_name : regular_binding_name;
         binding_wf_opt   =
             std::make_shared<wf::config::option_t<std::string>>(key_option->name,
                 binding_wf_opt->get_value_str());
-        section->register_new_option(binding_wf_opt);
-        WCM::get_instance()->save_config(option->plugin);
+        wcm->register_option(section, binding_wf_opt);
+        wcm->commit();
     });
     type_box.pack_start(type_combo_box, true, true);
     vbox.pack_start(type_box, false, false);
@@ -818,11 +885,13 @@ BindingsDynamicList::BindingWidget::BindingWidget(const std::string & cmd_name,
     remove_button.signal_clicked().connect([=]
     {
         ((BindingsDynamicList*)get_parent())->remove(this);
-        section->unregister_option(always_opt);
-        section->unregister_option(repeatable_opt);
-        section->unregister_option(regular_opt);
-        section->unregister_option(executable_opt);
-        WCM::get_instance()->save_config(option->plugin);
+        auto *wcm = WCM::get_instance();
+        wcm->begin();
+        wcm->unregister_option(section, always_opt);
+        wcm->unregister_option(section, repeatable_opt);
+        wcm->unregister_option(section, regular_opt);
+        wcm->unregister_option(section, executable_opt);
+        wcm->commit();
     });
     command_box.pack_start(remove_button, false, false);
     vbox.pack_start(command_box);
@@ -845,21 +914,22 @@ VswitchBindingsDynamicList<kind>::BindingWidget::BindingWidget(std::shared_ptr<w
     remove_button.signal_clicked().connect([=] ()
     {
         ((VswitchBindingsDynamicList<kind>*)get_parent())->remove(this);
-        section->unregister_option(binding_wf_opt);
-        WCM::get_instance()->save_config(option->plugin);
+        WCM::get_instance()->unregister_option(section, binding_wf_opt);
     });
 
     workspace_spin_button.set_tooltip_text(_("Workspace Index"));
     workspace_spin_button.set_value(workspace_index);
     workspace_spin_button.signal_value_changed().connect([=]
     {
-        section->unregister_option(binding_wf_opt);
+        auto *wcm = WCM::get_instance();
+        wcm->begin();
+        wcm->unregister_option(section, binding_wf_opt);
         key_option->name = OPTION_PREFIX + std::to_string(workspace_spin_button.get_value_as_int());
         binding_wf_opt   =
             std::make_shared<wf::config::option_t<std::string>>(key_option->name,
                 binding_wf_opt->get_value_str());
-        section->register_new_option(binding_wf_opt);
-        WCM::get_instance()->save_config(option->plugin);
+        wcm->register_option(section, binding_wf_opt);
+        wcm->commit();
     });
 
     pack_start(label, false, false);
@@ -887,17 +957,17 @@ AutostartDynamicList::AutostartDynamicList(Option *option)
     auto wf_option = std::dynamic_pointer_cast<wf::config::compound_option_t>(section->get_option(
         "autostart"));
     auto autostart_names = wf_option->get_value<std::string>();
-    option->options.clear();
+    option->clear_children();
 
     for (const auto & [opt_name, executable] : autostart_names)
     {
-        if (std::get<std::string>(option->default_value) != "string")
+        if (option->default_string() != "string")
         {
             continue;
         }
 
         Option *dyn_opt = option->create_child_option(opt_name, OPTION_TYPE_STRING);
-        dyn_opt->default_value = executable;
+        dyn_opt->set_default(executable);
 
         pack_widget(std::make_unique<AutostartWidget>(dyn_opt));
     }
@@ -914,11 +984,10 @@ AutostartDynamicList::AutostartDynamicList(Option *option)
 
         const auto name = prefix + std::to_string(i);
         const std::string executable = "<command>";
-        section->register_new_option(std::make_shared<wf::config::option_t<std::string>>(
-            name, executable));
-        WCM::get_instance()->save_config(option->plugin);
+        WCM::get_instance()->register_option(section,
+            std::make_shared<wf::config::option_t<std::string>>(name, executable));
         Option *dyn_opt = option->create_child_option(name, OPTION_TYPE_STRING);
-        dyn_opt->default_value = executable;
+        dyn_opt->set_default(executable);
         pack_widget(std::make_unique<AutostartWidget>(dyn_opt));
         show_all();
     });
@@ -943,7 +1012,7 @@ BindingsDynamicList::BindingsDynamicList(Option *option)
         }
     }
 
-    option->options.clear();
+    option->clear_children();
     for (const auto & cmd_name : command_names)
     {
         pack_widget(std::make_unique<BindingWidget>(cmd_name, option, section));
@@ -958,12 +1027,14 @@ BindingsDynamicList::BindingsDynamicList(Option *option)
         }
 
         const auto cmd_name = std::to_string(i);
-        section->register_new_option(std::make_shared<wf::config::option_t<std::string>>(
+        auto *wcm = WCM::get_instance();
+        wcm->begin();
+        wcm->register_option(section, std::make_shared<wf::config::option_t<std::string>>(
             exec_prefix + cmd_name, ""));
-        section->register_new_option(
+        wcm->register_option(section,
             std::make_shared<wf::config::option_t<std::string>>("binding_" +
                 cmd_name, "none"));
-        WCM::get_instance()->save_config(option->plugin);
+        wcm->commit();
         pack_widget(std::make_unique<BindingWidget>(cmd_name, option, section));
         show_all();
     });
@@ -989,7 +1060,7 @@ template<enum VswitchBindingKind kind>
 VswitchBindingsDynamicList<kind>::VswitchBindingsDynamicList(Option *option)
 {
     auto section = WCM::get_instance()->get_config_section(option->plugin);
-    option->options.clear();
+    option->clear_children();
 
     for (auto vswitch_option : section->get_registered_options())
     {
@@ -1016,11 +1087,10 @@ VswitchBindingsDynamicList<kind>::VswitchBindingsDynamicList(Option *option)
 
         Option *binding_option =
             option->create_child_option(OPTION_PREFIX + std::to_string(workspace_index), OPTION_TYPE_STRING);
-        section->register_new_option(std::make_shared<wf::config::option_t<std::string>>(
-            binding_option->name, ""));
+        WCM::get_instance()->register_option(section,
+            std::make_shared<wf::config::option_t<std::string>>(binding_option->name, ""));
         pack_widget(std::make_unique<BindingWidget>(section, binding_option, workspace_index));
         show_all();
-        WCM::get_instance()->save_config(option->plugin);
     });
 }
 
@@ -1035,7 +1105,7 @@ VswitchBindingsWidget<kind>::VswitchBindingsWidget(Option *option) : dynamic_lis
 OptionSubgroupWidget::OptionSubgroupWidget(Option *subgroup)
 {
     add(expander);
-    expander.set_label(subgroup->name);
+    expander.set_label(subgroup->name.str());
     expander.add(expander_layout);
     for (Option *option : subgroup->options)
     {
@@ -1052,16 +1122,16 @@ OptionGroupWidget::OptionGroupWidget(Option *group)
 
     for (Option *option : group->options)
     {
-        if (option->hidden)
+        if (option->hidden())
         {
             continue;
         }
 
         bool fill_expand = false;
-        if ((option->type == OPTION_TYPE_SUBGROUP) && !option->options.empty())
+        if ((option->type() == OPTION_TYPE_SUBGROUP) && !option->options.empty())
         {
             option_widgets.push_back(std::make_unique<OptionSubgroupWidget>(option));
-        } else if (option->type == OPTION_TYPE_DYNAMIC_LIST)
+        } else if (option->type() == OPTION_TYPE_DYNAMIC_LIST)
         {
             std::cout << option->name << std::endl;
             if (option->name == "autostart")
@@ -1103,17 +1173,16 @@ OptionGroupWidget::OptionGroupWidget(Option *group)
 
 PluginPage::PluginPage(Plugin *plugin)
 {
-    std::string gettext_domain_name = "wf-plugin-" + plugin->name;
     set_scrollable();
     for (auto *group : plugin->option_groups)
     {
-        if ((group->type != OPTION_TYPE_GROUP) || group->hidden)
+        if ((group->type() != OPTION_TYPE_GROUP) || group->hidden())
         {
             continue;
         }
 
         groups.emplace_back(group);
-        append_page(groups.back(), dgettext(gettext_domain_name.c_str(), group->name.c_str()));
+        append_page(groups.back(), plugin->translate(group->name).str());
     }
 }
 
@@ -1132,66 +1201,98 @@ MainPage::Category::Category(const Glib::ustring & name,
     flowbox.set_selection_mode(Gtk::SELECTION_NONE);
     flowbox.set_halign(Gtk::ALIGN_START);
     flowbox.set_min_children_per_line(3);
+    flowbox.set_homogeneous(true);
+    flowbox.bind_list_store<PluginItem>(store, [] (const Glib::RefPtr<PluginItem> & item) -> Gtk::Widget*
+    {
+        return Gtk::manage(new PluginWidget(item->plugin));
+    });
 }
 
-void Plugin::init_widget()
+MainPage::PluginWidget::PluginWidget(Plugin *plugin) : Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 5),
+    plugin(plugin)
 {
-    const auto icon_path = WCM::get_instance()->find_icon("plugin-" + name + ".svg");
-    if (std::filesystem::exists(icon_path))
-    {
-        icon.set(icon_path);
-    } else
+    set_halign(Gtk::ALIGN_START);
+
+    // show a placeholder until the plugin icon has been decoded
+    icon.set_from_icon_name("wcm", Gtk::ICON_SIZE_DND);
+    int icon_width, icon_height;
+    Gtk::IconSize::lookup(Gtk::ICON_SIZE_DND, icon_width, icon_height);
+    const int scale = get_scale_factor();
+    WCM::get_instance()->load_icon("plugin-" + plugin->name + ".svg", icon_width * scale,
+        sigc::track_obj([this, scale] (const Glib::RefPtr<Gdk::Pixbuf> & pixbuf)
     {
-        icon.set_from_icon_name("wcm", Gtk::ICON_SIZE_DND);
-    }
+        auto surface = gdk_cairo_surface_create_from_pixbuf(pixbuf->gobj(), scale, nullptr);
+        gtk_image_set_from_surface(icon.gobj(), surface);
+        cairo_surface_destroy(surface);
+    }, *this));
 
     button_layout.pack_start(icon);
-    std::string gettext_domain_name = "wf-plugin-" + name;
-    label.set_text(dgettext(gettext_domain_name.c_str(), disp_name.c_str()));
+    label.set_text(plugin->translate(plugin->disp_name).str());
     label.set_ellipsize(Pango::ELLIPSIZE_END);
+    // fixed width keeps the items of all categories the same size
+    label.set_width_chars(PLUGIN_LABEL_WIDTH_CHARS);
+    label.set_max_width_chars(PLUGIN_LABEL_WIDTH_CHARS);
+    label.set_xalign(0);
     button_layout.pack_start(label);
     button_layout.set_halign(Gtk::ALIGN_START);
-    button.set_tooltip_markup(dgettext(gettext_domain_name.c_str(), tooltip.c_str()));
+    button.set_tooltip_markup(plugin->translate(plugin->tooltip).str());
     button.set_relief(Gtk::RELIEF_NONE);
     button.add(button_layout);
-    enabled_check.set_active(enabled);
-    widget.set_halign(Gtk::ALIGN_START);
-    widget.pack_start(enabled_check, false, false);
-    if (!is_core_plugin() && (type == PLUGIN_TYPE_WAYFIRE))
+    enabled_check.set_active(plugin->enabled);
+    pack_start(enabled_check, false, false);
+    if (!plugin->is_core_plugin() && (plugin->type == PLUGIN_TYPE_WAYFIRE))
     {
-        enabled_check.signal_toggled().connect(
-            [=]
+        enabled_check.signal_toggled().connect([this]
         {
-            WCM::get_instance()->set_plugin_enabled(this,
-                enabled_check.get_active());
+            WCM::get_instance()->set_plugin_enabled(this->plugin, enabled_check.get_active());
         });
+        plugin->enabled_changed.connect(sigc::track_obj([this]
+        {
+            enabled_check.set_active(this->plugin->enabled);
+        }, *this));
     } else
     {
         enabled_check.set_sensitive(false);
         // enabled_check.set_opacity(0);
     }
 
-    widget.pack_start(button);
-    button.signal_clicked().connect([=] { WCM::get_instance()->open_page(this); });
-}
-
-void MainPage::Category::add_plugin(Plugin *plugin)
-{
-    plugin->init_widget();
-    flowbox.add(plugin->widget);
+    pack_start(button);
+    button.signal_clicked().connect([this] { WCM::get_instance()->open_page(this->plugin); });
+    show_all_children();
 }
 
 MainPage::MainPage(const std::vector<Plugin*> & plugins) : plugins(plugins)
 {
     add(vbox);
+    std::array<std::vector<Glib::RefPtr<PluginItem>>, NUM_CATEGORIES> items;
+    // plugins share a handful of categories, translate and look up each once
+    std::unordered_map<InternedString, size_t> category_index;
     for (auto *plugin : plugins)
     {
-        std::find_if(categories.begin(), categories.end() - 1,
-            [=] (const Category & cat)
+        auto [index, inserted] = category_index.emplace(plugin->category, 0);
+        if (inserted)
         {
-            return cat.name == Glib::ustring(_(plugin->category.c_str()));
-        })->add_plugin(plugin);
-        size_group->add_widget(plugin->widget);
+            const Glib::ustring category_name = _(plugin->category.c_str());
+            auto it = std::find_if(categories.begin(), categories.end() - 1,
+                [&] (const Category & cat)
+            {
+                return cat.name == category_name;
+            });
+            index->second = it - categories.begin();
+        }
+
+        items[index->second].push_back(PluginItem::create(plugin));
+    }
+
+    for (int i = 0; i < NUM_CATEGORIES; ++i)
+    {
+        auto & category = categories[i];
+        category.flowbox.set_filter_func([this, store = category.store] (Gtk::FlowBoxChild *child)
+        {
+            return plugin_visible(store->get_item(child->get_index())->plugin);
+        });
+        // one splice per category, so the flowbox is populated in one go
+        category.store->splice(0, 0, items[i]);
     }
 
     vbox.add(categories[0].vbox);
@@ -1205,74 +1306,40 @@ MainPage::MainPage(const std::vector<Plugin*> & plugins) : plugins(plugins)
     signal_show().connect([=] { set_filter(""); });
 }
 
+bool MainPage::plugin_visible(Plugin *plugin) const
+{
+    return find_string(plugin->name, filter) || find_string(plugin->disp_name, filter) ||
+           find_string(plugin->tooltip, filter);
+}
+
 void MainPage::set_filter(const Glib::ustring & filter)
 {
-    std::map<std::string, bool> category_visible;
-    for (const auto & cat : categories)
-    {
-        category_visible.insert({cat.name, false});
-    }
+    this->filter = filter;
 
-    for (auto *plug : plugins)
+    std::array<bool, NUM_CATEGORIES> category_visible;
+    for (int i = 0; i < NUM_CATEGORIES; ++i)
     {
-        bool plug_visible = find_string(plug->name, filter) || find_string(
-            plug->disp_name, filter) ||
-            find_string(plug->tooltip, filter);
-        // the parent of `plug->widget` is `Gtk::FlowBoxItem`
-        plug->widget.get_parent()->set_visible(plug_visible);
-        category_visible[_(plug->category.c_str())] |= plug_visible;
+        auto & category = categories[i];
+        category.flowbox.invalidate_filter();
+        category_visible[i] = false;
+        for (guint j = 0; j < category.store->get_n_items() && !category_visible[i]; ++j)
+        {
+            category_visible[i] = plugin_visible(category.store->get_item(j)->plugin);
+        }
     }
 
-    categories[0].vbox.set_visible(category_visible[categories[0].name]);
+    categories[0].vbox.set_visible(category_visible[0]);
     for (int i = 0; i < NUM_CATEGORIES - 1; ++i)
     {
-        separators[i].set_visible(category_visible[categories[i].name]);
-        categories[i + 1].vbox.set_visible(category_visible[categories[i + 1].name]);
+        separators[i].set_visible(category_visible[i]);
+        categories[i + 1].vbox.set_visible(category_visible[i + 1]);
     }
 }
 
 void WCM::parse_config(wf::config::config_manager_t & config_manager)
 {
-    for (auto & s : config_manager.get_all_sections())
-    {
-        xmlNode *root_element = wf::config::xml::get_section_xml_node(s);
-
-        if (!root_element)
-        {
-            continue;
-        }
-
-        root_element = root_element->parent;
-        std::string root_name = (char*)root_element->name;
-
-        if ((root_element->type == XML_ELEMENT_NODE) &&
-            ((root_name == "wayfire") || (root_name == "wf-shell")))
-        {
-            printf("Loading %s plugin: %s\n", root_element->name,
-                s->get_name().c_str());
-            Plugin *p = Plugin::get_plugin_data(root_element);
-            if (p)
-            {
-                plugins.push_back(p);
-            } else
-            {
-                continue;
-            }
-
-            if (root_name == "wayfire")
-            {
-                p->type = PLUGIN_TYPE_WAYFIRE;
-            } else if (root_name == "wf-shell")
-            {
-                p->type = PLUGIN_TYPE_WF_SHELL;
-            } else
-            {
-                // Should be unreachable because `root_name` is "wayfire" or
-                // "wf-shell"
-                p->type = PLUGIN_TYPE_NONE;
-            }
-        }
-    }
+    auto parsed = Plugin::get_plugins_data(config_manager, &profiler);
+    plugins.insert(plugins.end(), parsed.begin(), parsed.end());
 }
 
 std::string::size_type find_plugin(Plugin *p, const std::string & plugins)
@@ -1307,7 +1374,9 @@ bool plugin_enabled(Plugin *p, const std::string & plugins)
            std::string::npos;
 }
 
-WCM::WCM(Glib::RefPtr<Gtk::Application> app)
+WCM::WCM(Glib::RefPtr<Gtk::Application> app) :
+    save_scheduler(sigc::mem_fun(*this, &WCM::save_to_file)),
+    config_watcher(sigc::mem_fun(*this, &WCM::config_file_changed))
 {
     if (instance)
     {
@@ -1315,6 +1384,8 @@ WCM::WCM(Glib::RefPtr<Gtk::Application> app)
     }
 
     instance = this;
+    config_writer.set_written_callback(sigc::mem_fun(*this, &WCM::config_file_written));
+    config_writer.set_logged_callback(sigc::mem_fun(*this, &WCM::changes_logged));
 
     app->add_main_option_entry([this] (const Glib::ustring &, const Glib::ustring & value, bool)
     {
@@ -1331,38 +1402,176 @@ WCM::WCM(Glib::RefPtr<Gtk::Application> app)
         start_plugin = value;
         return true;
     }, "plugin", 'p', _("plugin to open at launch, or none for default"), "name");
+    app->add_main_option_entry([this] (const Glib::ustring &, const Glib::ustring & value, bool)
+    {
+        profiler.set_output(value);
+        return true;
+    }, "profile-startup", 0, _("write startup timings as JSON to file, or - for stdout"), "file");
+    app->add_main_option_entry([this] (const Glib::ustring &, const Glib::ustring & value, bool)
+    {
+        const int delay = std::atoi(value.c_str());
+        if (delay < 0)
+        {
+            return false;
+        }
+
+        save_scheduler.set_delays(std::chrono::milliseconds(delay),
+            SaveScheduler::DEFAULT_MAX_LATENCY);
+        return true;
+    }, "save-delay", 0, _("milliseconds without changes before the config is written"), "ms");
+    app->add_main_option_entry([this] (const Glib::ustring &, const Glib::ustring &, bool)
+    {
+        save_metrics.set_print(true);
+        return true;
+    }, "stats", 0, _("print save latency and size statistics on exit"), "",
+        Glib::OptionEntry::FLAG_NO_ARG);
+    app->add_main_option_entry([this] (const Glib::ustring &, const Glib::ustring & value, bool)
+    {
+        save_metrics.set_output(value);
+        return true;
+    }, "stats-json", 0, _("write save statistics as JSON to file on exit, or - for stdout"),
+        "file");
 
     app->signal_startup().connect([this, app] ()
     {
-        load_config_files();
-        parse_config();
+        {
+            auto scope = profiler.measure("load_config_files");
+            load_config_files();
+        }
+
+        config_watcher.watch(wf_config_file);
+#if HAVE_WFSHELL
+        config_watcher.watch(wf_shell_config_file);
+#endif
+        replay_unsaved_changes();
+
+        bool cache_loaded;
+        {
+            auto scope = profiler.measure("metadata_cache");
+            cache_loaded = metadata_cache.load(plugins);
+        }
+
+        if (!cache_loaded)
+        {
+            {
+                auto scope = profiler.measure("parse_config");
+                parse_config();
+            }
+
 #if HAVE_WFSHELL
-        parse_wfshell_config();
+            {
+                auto scope = profiler.measure("parse_wfshell_config");
+                parse_wfshell_config();
+            }
 #endif
+            // Rebuild the cache in the background, one plugin per iteration
+            Glib::signal_idle().connect([this]
+            {
+                if (cache_index < plugins.size())
+                {
+                    metadata_cache.add(plugins[cache_index++]);
+                    return true;
+                }
+
+                metadata_cache.store();
+                return false;
+            }, Glib::PRIORITY_LOW);
+        }
+
+        {
+            auto scope = profiler.measure("init_input_inhibitor");
+            if (!init_input_inhibitor())
+            {
+                std::cerr << "Binding grabs will not work" << std::endl;
+            }
+        }
 
-        if (!init_input_inhibitor())
         {
-            std::cerr << "Binding grabs will not work" << std::endl;
+            auto scope = profiler.measure("enable_plugins");
+            const auto plugins_str =
+                wf_config_mgr.get_section("core")->get_option("plugins")->get_value_str();
+            for (auto *plugin : plugins)
+            {
+                plugin->enabled = plugin_enabled(plugin, plugins_str);
+            }
         }
 
-        const auto plugins_str =
-            wf_config_mgr.get_section("core")->get_option("plugins")->get_value_str();
-        for (auto *plugin : plugins)
+        // Parse the XKB rules in the background before the input page needs them
+        Glib::signal_idle().connect_once([this]
+        {
+            get_xkb_registry(get_xkb_rules());
+        }, Glib::PRIORITY_LOW);
+
+        window = std::make_unique<Gtk::ApplicationWindow>(app);
+        const auto icon_path = find_icon("wcm.svg");
+        if (!icon_path.empty())
         {
-            plugin->enabled = plugin_enabled(plugin, plugins_str);
+            window->set_icon(Gdk::Pixbuf::create_from_file(icon_path));
         }
 
-        window    = std::make_unique<Gtk::ApplicationWindow>(app);
-        auto icon = Gdk::Pixbuf::create_from_file(find_icon("wcm.svg"));
-        window->set_icon(icon);
         window->set_size_request(750, 550);
         window->set_default_size(1000, 580);
         window->set_title(_("Wayfire Config Manager"));
-        create_main_layout();
+        {
+            auto scope = profiler.measure("create_main_layout");
+            create_main_layout();
+        }
+
+        if (profiler.enabled())
+        {
+            first_frame_connection = window->signal_draw().connect(
+                [this] (const Cairo::RefPtr<Cairo::Context>&)
+            {
+                profiler.mark("first_frame");
+                first_frame_connection.disconnect();
+                return false;
+            }, false);
+        }
+
+        auto scope = profiler.measure("show_all");
         window->show_all();
     });
 
     app->signal_activate().connect([&] { window->present(); });
+    app->signal_shutdown().connect([this]
+    {
+        flush_config();
+        profiler.write();
+    });
+}
+
+WCM::~WCM()
+{
+    // The widgets refer to the plugins and their options
+    plugin_page.reset();
+    main_page.reset();
+    // the writes are reported to clear the write-ahead log, but the files
+    // are not reloaded anymore
+    deferred_reloads.clear();
+    // destroying the widgets may have scheduled saves, and synced log
+    // batches or files which could not be patched schedule more
+    do
+    {
+        flush_config();
+        config_writer.finish();
+    } while (save_scheduler.pending() || !queued_saves.empty());
+
+    save_metrics.write();
+    for (auto *plugin : plugins)
+    {
+        delete plugin;
+    }
+
+    instance = nullptr;
+}
+
+void WCM::quit()
+{
+    flush_config();
+    if (window)
+    {
+        window->get_application()->quit();
+    }
 }
 
 static void registry_add_object(void *data, struct wl_registry *registry,
@@ -1386,6 +1595,18 @@ static struct wl_registry_listener registry_listener = {
     &registry_add_object, &registry_remove_object
 };
 
+static void registry_done(void *data, struct wl_callback *callback, uint32_t serial)
+{
+    WCM *wcm = (WCM*)data;
+
+    wl_callback_destroy(callback);
+    wcm->set_registry_synced();
+}
+
+static struct wl_callback_listener registry_sync_listener = {
+    &registry_done
+};
+
 bool WCM::init_input_inhibitor()
 {
     struct wl_display *display = gdk_wayland_display_get_wl_display(
@@ -1406,22 +1627,37 @@ bool WCM::init_input_inhibitor()
         return false;
     }
 
+    // Don't block on the compositor here: GDK dispatches the default queue
+    // from the main loop, so the globals and the sync callback arrive there.
     wl_registry_add_listener(registry, &registry_listener, this);
-    wl_display_dispatch(display);
-    wl_display_roundtrip(display);
+    wl_callback_add_listener(wl_display_sync(display), &registry_sync_listener, this);
+    wl_display_flush(display);
+
+    return true;
+}
+
+void WCM::set_registry_synced()
+{
+    registry_synced = true;
     if (!inhibitor_manager)
     {
         std::cerr << "Compositor does not advertise " <<
             "zwp_keyboard_shortcuts_inhibit_manager_v1" << std::endl;
-
-        return false;
     }
-
-    return true;
 }
 
 bool WCM::lock_input(Gtk::Dialog *grab_dialog)
 {
+    if (!inhibitor_manager && !registry_synced)
+    {
+        // A grab was started before the main loop got the globals
+        GdkDisplay *gdk_display = gdk_display_get_default();
+        if (GDK_IS_WAYLAND_DISPLAY(gdk_display))
+        {
+            wl_display_roundtrip(gdk_wayland_display_get_wl_display(gdk_display));
+        }
+    }
+
     if (!inhibitor_manager)
     {
         std::cerr << "Compositor does not advertise zwp_keyboard_shortcuts_inhibit_manager_v1!" <<
@@ -1474,9 +1710,9 @@ void WCM::set_plugin_enabled(Plugin *plugin, bool enabled)
     }
 
     plugin->enabled = enabled;
-    plugin->enabled_check.set_active(enabled);
-    auto wf_opt = wf_config_mgr.get_section("core")->get_option("plugins");
-    std::string enabled_plugins = wf_opt->get_value_str();
+    plugin->enabled_changed.emit();
+    auto core_section = wf_config_mgr.get_section("core");
+    std::string enabled_plugins = core_section->get_option("plugins")->get_value_str();
 
     if (!enabled)
     {
@@ -1504,17 +1740,30 @@ void WCM::set_plugin_enabled(Plugin *plugin, bool enabled)
         enabled_plugins.append((enabled_plugins.empty() ? "" : " ") + plugin->name);
     }
 
-    wf_opt->set_value_str(enabled_plugins);
-    save_to_file(wf_config_mgr, wf_config_file);
+    set_option(core_section, "plugins", enabled_plugins);
 }
 
 void WCM::create_main_layout()
 {
-    window->signal_key_press_event().connect([] (GdkEventKey *event)
+    window->signal_key_press_event().connect([this] (GdkEventKey *event)
     {
         if (event->state & GDK_CONTROL_MASK && (event->keyval == GDK_KEY_q))
         {
-            std::exit(0);
+            quit();
+        }
+
+        if (event->state & GDK_CONTROL_MASK &&
+            ((event->keyval == GDK_KEY_z) || (event->keyval == GDK_KEY_Z)))
+        {
+            if (event->state & GDK_SHIFT_MASK)
+            {
+                redo();
+            } else
+            {
+                undo();
+            }
+
+            return true;
         }
 
         return false;
@@ -1543,22 +1792,34 @@ void WCM::create_main_layout()
     main_left_panel_layout.pack_start(search_entry, false, false);
 
     close_button.property_margin().set_value(10);
-    close_button.signal_clicked().connect([] { std::exit(0); });
+    close_button.signal_clicked().connect([this] { quit(); });
     main_left_panel_layout.pack_end(close_button, false, false);
 
     output_config_button.property_margin().set_value(10);
-    output_config_button.signal_clicked().connect([]
+    output_config_button.signal_clicked().connect([this]
     {
-        Glib::spawn_command_line_async(OUTPUT_CONFIG_PROGRAM);
+        try {
+            Glib::spawn_async("", std::vector<std::string>{output_config_program},
+                Glib::SPAWN_DEFAULT);
+        } catch (const Glib::Error & e)
+        {
+            std::cerr << "Failed to start " << output_config_program << ": " << e.what() << std::endl;
+        }
     });
     main_left_panel_layout.pack_end(output_config_button, false, false);
 
-    if (system("command -v " OUTPUT_CONFIG_PROGRAM " > /dev/null 2>&1") != 0)
+    // The button stays insensitive until the program is found
+    output_config_button.set_sensitive(false);
+    program_probe.find(OUTPUT_CONFIG_PROGRAM, [this] (const std::string & path)
     {
-        output_config_button.set_sensitive(false);
-        output_config_button.set_tooltip_markup(
-            _("Cannot find program <tt>wdisplays</tt>"));
-    }
+        output_config_program = path;
+        output_config_button.set_sensitive(!path.empty());
+        if (path.empty())
+        {
+            output_config_button.set_tooltip_markup(
+                _("Cannot find program <tt>wdisplays</tt>"));
+        }
+    });
 
     plugin_left_panel_layout.pack_start(plugin_name_label, false, false);
     plugin_name_label.set_line_wrap();
@@ -1611,16 +1872,19 @@ void WCM::open_page(Plugin *plugin)
 {
     if (plugin)
     {
-        std::string gettext_domain_name = "wf-plugin-" + plugin->name;
         plugin_enabled_box.set_visible(
             !plugin->is_core_plugin() && plugin->type != PLUGIN_TYPE_WF_SHELL);
         plugin_enabled_check.set_active(plugin->enabled);
         plugin_name_label.set_markup(
             "<span size=\"12000\"><b>" +
-            std::string(dgettext(gettext_domain_name.c_str(), plugin->disp_name.c_str())) + "</b></span>");
+            plugin->translate(plugin->disp_name).str() + "</b></span>");
         plugin_description_label.set_markup(
             "<span size=\"10000\"><b>" +
-            std::string(dgettext(gettext_domain_name.c_str(), plugin->tooltip.c_str())) + "</b></span>");
+            plugin->translate(plugin->tooltip).str() + "</b></span>");
+        plugin->load_options();
+        // Dynamic lists recycle their child options, so the widgets of the
+        // previous page must be gone before the new page is built
+        plugin_page.reset();
         plugin_page = std::make_unique<PluginPage>(plugin);
         main_stack.add(*plugin_page);
         plugin_page->show_all();
@@ -1654,6 +1918,12 @@ void WCM::load_config_files()
         wf_config_file = wordexp_str(wf_config_file_override ? wf_config_file_override : WAYFIRE_CONFIG_FILE);
     }
 
+    if (wf_shell_config_file.empty())
+    {
+        wf_shell_config_file = wordexp_str(
+            wf_shell_config_file_override ? wf_shell_config_file_override : WF_SHELL_CONFIG_FILE);
+    }
+
     std::vector<std::string> wayfire_xmldirs;
     if (char *plugin_xml_path = getenv("WAYFIRE_PLUGIN_XML_PATH"))
     {
@@ -1666,36 +1936,96 @@ void WCM::load_config_files()
     }
 
     wayfire_xmldirs.push_back(WAYFIRE_METADATADIR);
+    std::vector<std::string> metadata_dirs = wayfire_xmldirs;
+
+    // libxml2 must be initialized on the main thread before parsing from
+    // several threads at once
+    xmlInitParser();
+
+#if HAVE_WFSHELL
+    std::vector<std::string> wf_shell_xmldirs(1, WFSHELL_METADATADIR);
+    metadata_dirs.insert(metadata_dirs.end(), wf_shell_xmldirs.begin(), wf_shell_xmldirs.end());
+    auto wf_shell_config_future = std::async(std::launch::async, [=]
+    {
+        return wf::config::build_configuration(
+            wf_shell_xmldirs, WFSHELL_SYSCONFDIR "/wayfire/wf-shell-defaults.ini",
+            wf_shell_config_file);
+    });
+#endif
+
+    auto metadata_cache_future = std::async(std::launch::async, [=]
+    {
+        return MetadataCache(metadata_dirs);
+    });
+
+    std::vector<std::string> config_files{wf_config_file};
+#if HAVE_WFSHELL
+    config_files.push_back(wf_shell_config_file);
+#endif
+    auto disk_contents_future = std::async(std::launch::async, [config_files]
+    {
+        std::unordered_map<std::string, std::string> contents;
+        for (const auto & file : config_files)
+        {
+            if (auto text = read_file(file))
+            {
+                contents[file] = std::move(*text);
+            }
+        }
+
+        return contents;
+    });
 
     wf_config_mgr =
         wf::config::build_configuration(wayfire_xmldirs,
             WAYFIRE_SYSCONFDIR "/wayfire/defaults.ini",
             wf_config_file);
 
-    if (wf_shell_config_file.empty())
+#if HAVE_WFSHELL
+    wf_shell_config_mgr = wf_shell_config_future.get();
+#endif
+    metadata_cache = metadata_cache_future.get();
+    disk_contents = disk_contents_future.get();
+    for (const auto & [file, contents] : disk_contents)
     {
-        wf_shell_config_file = wordexp_str(
-            wf_shell_config_file_override ? wf_shell_config_file_override : WF_SHELL_CONFIG_FILE);
+        config_writer.load(file, contents);
     }
+}
 
-#if HAVE_WFSHELL
-    std::vector<std::string> wf_shell_xmldirs(1, WFSHELL_METADATADIR);
-    wf_shell_config_mgr = wf::config::build_configuration(
-        wf_shell_xmldirs, WFSHELL_SYSCONFDIR "/wayfire/wf-shell-defaults.ini",
-        wf_shell_config_file);
-#endif
+/**
+ * The options of a section which are not described by the metadata, sorted by
+ * name. The entries of a compound option with a given prefix are then one
+ * contiguous range.
+ */
+using prefix_index_t = std::vector<std::shared_ptr<wf::config::option_base_t>>;
+
+static prefix_index_t build_prefix_index(const std::shared_ptr<wf::config::section_t> & section)
+{
+    prefix_index_t index;
+    for (auto & opt : section->get_registered_options())
+    {
+        if (!wf::config::xml::get_option_xml_node(opt))
+        {
+            index.push_back(opt);
+        }
+    }
+
+    std::sort(index.begin(), index.end(), [] (const auto & a, const auto & b)
+    {
+        return a->get_name() < b->get_name();
+    });
+    return index;
 }
 
 /**
  * Adapted from wf-config internal source code.
  *
- * Go through all options in the section, try to match them against the prefix
+ * Go through the options of the section which match the prefix of an entry
  * of the compound option, thus build a new value and set it.
  */
-void update_compound_from_section(wf::config::compound_option_t *compound,
-    const std::shared_ptr<wf::config::section_t> & section)
+static void update_compound_from_section(wf::config::compound_option_t *compound,
+    const prefix_index_t & index)
 {
-    auto options = section->get_registered_options();
     std::vector<std::vector<std::string>> new_value;
 
     struct tuple_in_construction_t
@@ -1711,43 +2041,41 @@ void update_compound_from_section(wf::config::compound_option_t *compound,
     for (size_t n = 0; n < entries.size(); n++)
     {
         const auto & prefix = entries[n]->get_prefix();
-        for (auto & opt : options)
+        auto it = std::lower_bound(index.begin(), index.end(), prefix,
+            [] (const auto & opt, const std::string & name)
+        {
+            return opt->get_name() < name;
+        });
+        for (; (it != index.end()) && begins_with((*it)->get_name(), prefix); ++it)
         {
-            if (wf::config::xml::get_option_xml_node(opt))
+            const auto & opt = *it;
+            // We have found a match.
+            // Find the suffix we should store values in.
+            std::string suffix = opt->get_name().substr(prefix.size());
+            if (!new_values.count(suffix) && (n > 0))
             {
+                // Skip entries which did not have their first value set,
+                // because these will not be fully constructed in the end.
                 continue;
             }
 
-            if (begins_with(opt->get_name(), prefix))
-            {
-                // We have found a match.
-                // Find the suffix we should store values in.
-                std::string suffix = opt->get_name().substr(prefix.size());
-                if (!new_values.count(suffix) && (n > 0))
-                {
-                    // Skip entries which did not have their first value set,
-                    // because these will not be fully constructed in the end.
-                    continue;
-                }
-
-                auto & tuple = new_values[suffix];
-
-                // Parse the value from the option, with the n-th type.
-                if (!entries[n]->is_parsable(opt->get_value_str()))
-                {
-                    continue;
-                }
+            auto & tuple = new_values[suffix];
 
-                if (n == 0)
-                {
-                    // Push the suffix first
-                    tuple.push_back(suffix);
-                }
+            // Parse the value from the option, with the n-th type.
+            if (!entries[n]->is_parsable(opt->get_value_str()))
+            {
+                continue;
+            }
 
-                // Update the Nth entry in the tuple (+1 because the first entry
-                // is the amount of initialized entries).
-                tuple.push_back(opt->get_value_str());
+            if (n == 0)
+            {
+                // Push the suffix first
+                tuple.push_back(suffix);
             }
+
+            // Update the Nth entry in the tuple (+1 because the first entry
+            // is the amount of initialized entries).
+            tuple.push_back(opt->get_value_str());
         }
     }
 
@@ -1783,97 +2111,696 @@ Plugin*WCM::find_plugin_by_name(std::vector<Plugin*> plugins, std::string search
     return nullptr; // Return nullptr if not found
 }
 
-/**
- * Save the given configuration to the given file.
- *
- * Update the values of the compound options while doing this, as if
- * they were set from the config file. This is necessary because wf-config will only
- * save values in the compound list itself, not the options which represent the
- * entries in the list.
- */
-void WCM::save_to_file(wf::config::config_manager_t & mgr, const std::string & file)
+void WCM::update_compound_options(const std::shared_ptr<wf::config::section_t> & section)
 {
+    // the compound options come from the metadata, so they never change
+    auto [it, inserted] = compound_options.try_emplace(section.get());
+    if (inserted)
+    {
+        for (auto & opt : section->get_registered_options())
+        {
+            if (auto *as_compound = dynamic_cast<wf::config::compound_option_t*>(opt.get()))
+            {
+                it->second.push_back(as_compound);
+            }
+        }
+    }
+
+    if (it->second.empty())
+    {
+        return;
+    }
+
+    const auto index = build_prefix_index(section);
+    for (auto *compound : it->second)
+    {
+        update_compound_from_section(compound, index);
+    }
+}
+
+/**
+ * Save the given configuration to the given file.
+ *
+ * Update the values of the compound options while doing this, as if
+ * they were set from the config file. This is necessary because wf-config will only
+ * save values in the compound list itself, not the options which represent the
+ * entries in the list.
+ *
+ * Only the values of the changed sections are copied here. The writer thread
+ * serializes them and patches them into the file.
+ */
+void WCM::save_to_file(const SaveRequest & request)
+{
+    auto & mgr = *request.mgr;
+    const auto & file = request.file;
     std::cout << "Saving to file " << file << std::endl;
 
-    for (auto & section : mgr.get_all_sections())
+    std::vector<std::shared_ptr<wf::config::section_t>> changed;
+    if (request.whole_file)
     {
-        for (auto & opt : section->get_registered_options())
+        changed = mgr.get_all_sections();
+    } else
+    {
+        for (const auto & name : request.sections)
         {
-            auto as_compound =
-                dynamic_cast<wf::config::compound_option_t*>(opt.get());
-            if (as_compound)
+            if (auto section = mgr.get_section(name))
             {
-                update_compound_from_section(as_compound, section);
+                changed.push_back(section);
             }
         }
     }
 
-    wf::config::save_configuration_to_file(mgr, file);
+    std::vector<SectionSnapshot> snapshots;
+    snapshots.reserve(changed.size());
+    for (auto & section : changed)
+    {
+        update_compound_options(section);
+        snapshots.emplace_back(section);
+    }
+
+    save_metrics.queued(file);
+    queued_saves[file] = config_writer.save(file, std::move(snapshots), request.whole_file,
+        last_released);
 }
 
-bool WCM::save_config(Plugin *plugin)
+wf::config::config_manager_t *WCM::find_config(const wf_section & section,
+    const std::string **file)
 {
-    if (plugin->type == PLUGIN_TYPE_WAYFIRE)
+    const auto & name = section->get_name();
+    if (wf_config_mgr.get_section(name) == section)
     {
-        save_to_file(wf_config_mgr, wf_config_file);
-        return true;
+        *file = &wf_config_file;
+        return &wf_config_mgr;
     }
 
-    if (plugin->type == PLUGIN_TYPE_WF_SHELL)
+#if HAVE_WFSHELL
+    if (wf_shell_config_mgr.get_section(name) == section)
     {
-        save_to_file(wf_shell_config_mgr, wf_shell_config_file);
-        return true;
+        *file = &wf_shell_config_file;
+        return &wf_shell_config_mgr;
     }
 
-    return false;
+#endif
+    return nullptr;
 }
 
-std::shared_ptr<wf::config::section_t> WCM::get_config_section(Plugin *plugin)
+wf::config::config_manager_t *WCM::find_config(const std::string & file)
 {
-    if (plugin->type == PLUGIN_TYPE_WAYFIRE)
+    if (file == wf_config_file)
     {
-        return wf_config_mgr.get_section(plugin->name);
+        return &wf_config_mgr;
     }
 
-#ifdef HAVE_WFSHELL
-    if (plugin->type == PLUGIN_TYPE_WF_SHELL)
+#if HAVE_WFSHELL
+    if (file == wf_shell_config_file)
     {
-        return wf_shell_config_mgr.get_section(plugin->name);
+        return &wf_shell_config_mgr;
     }
 
 #endif
     return nullptr;
 }
 
-std::string WCM::find_icon(const std::string & name)
+bool WCM::save_config(const wf_section & section)
+{
+    const std::string *file;
+    if (auto *mgr = find_config(section, &file))
+    {
+        save_scheduler.schedule(*mgr, *file, section->get_name());
+        return true;
+    }
+
+    return false;
+}
+
+static void schedule_saves(SaveScheduler & scheduler, const std::vector<SaveRequest> & requests)
+{
+    for (const auto & request : requests)
+    {
+        for (const auto & section : request.sections)
+        {
+            scheduler.schedule(*request.mgr, request.file, section);
+        }
+    }
+}
+
+void WCM::save_changes(const std::vector<ConfigChange> & changes)
+{
+    std::vector<WriteAheadLog::record> records;
+    std::vector<SaveRequest> requests;
+    for (const auto & change : changes)
+    {
+        const std::string *file;
+        auto *mgr = find_config(change.section, &file);
+        if (!mgr)
+        {
+            continue;
+        }
+
+        // log the state of the option after the change, before it is saved
+        const auto & section = change.section->get_name();
+        const auto & option  = change.option->get_name();
+        std::optional<std::string> value;
+        if (change.section->get_option_or(option) == change.option)
+        {
+            value = change.option->get_value_str();
+        }
+
+        records.push_back({*file, section, option, std::move(value)});
+        auto request = std::find_if(requests.begin(), requests.end(),
+            [mgr] (const SaveRequest & request) { return request.mgr == mgr; });
+        if (request == requests.end())
+        {
+            requests.push_back({mgr, *file});
+            request = std::prev(requests.end());
+        }
+
+        request->sections.insert(section);
+    }
+
+    if (records.empty())
+    {
+        return;
+    }
+
+    if (config_writer.logging())
+    {
+        // the saves may only overwrite the files once the log holds the changes
+        pending_batches[config_writer.log(std::move(records))] = std::move(requests);
+        return;
+    }
+
+    schedule_saves(save_scheduler, requests);
+}
+
+void WCM::changes_logged(uint64_t batch, bool ok)
+{
+    if (!ok)
+    {
+        std::cerr << "Failed to log changes, saving them without a log" << std::endl;
+    }
+
+    auto it = pending_batches.find(batch);
+    if (it == pending_batches.end())
+    {
+        return;
+    }
+
+    schedule_saves(save_scheduler, it->second);
+
+    pending_batches.erase(it);
+    last_released = batch;
+}
+
+void WCM::replay_unsaved_changes()
+{
+    auto replay = config_writer.open_log(
+        get_xdg_dir("XDG_STATE_HOME", ".local/state") + "/wcm/pending.log");
+    if (replay.records.empty())
+    {
+        return;
+    }
+
+    std::cout << "Restoring " << replay.records.size() << " unsaved changes" << std::endl;
+    std::set<std::string> skipped;
+    begin();
+    for (const auto & record : replay.records)
+    {
+        auto *mgr = find_config(record.file);
+        if (!mgr)
+        {
+            std::cerr << "Dropping unsaved change of " << record.file << std::endl;
+            continue;
+        }
+
+        // the changes were made to the file as it was then, do not overwrite
+        // the edits made to it since
+        auto hash = replay.hashes.find(record.file);
+        if ((hash != replay.hashes.end()) &&
+            (hash->second != WriteAheadLog::hash(disk_contents[record.file])))
+        {
+            if (skipped.insert(record.file).second)
+            {
+                std::cerr << record.file << " changed since, not restoring its unsaved changes" <<
+                    std::endl;
+            }
+
+            continue;
+        }
+
+        auto section = mgr->get_section(record.section);
+        if (!section)
+        {
+            section = std::make_shared<wf::config::section_t>(record.section);
+            mgr->merge_section(section);
+        }
+
+        auto option = section->get_option_or(record.option);
+        if (!record.value)
+        {
+            unregister_option(section, option);
+        } else if (option)
+        {
+            set_option(section, record.option, *record.value);
+        } else
+        {
+            register_option(section,
+                std::make_shared<wf::config::option_t<std::string>>(record.option, *record.value));
+        }
+    }
+
+    commit();
+    // nothing was restored, the records are of no use anymore
+    if (pending_batches.empty())
+    {
+        config_writer.clear_log();
+    }
+}
+
+void WCM::flush_config()
+{
+    save_scheduler.flush();
+}
+
+void WCM::begin()
+{
+    transaction_starts.push_back(pending_changes.size());
+}
+
+void WCM::commit()
+{
+    if (transaction_starts.empty())
+    {
+        throw std::logic_error("commit() without a transaction");
+    }
+
+    transaction_starts.pop_back();
+    if (!transaction_starts.empty())
+    {
+        return;
+    }
+
+    // the scheduler merges the sections, so every file is written once
+    auto changes = std::move(pending_changes);
+    pending_changes.clear();
+    save_changes(changes);
+    journal.record(std::move(changes));
+}
+
+void WCM::undo()
+{
+    if (transaction_starts.empty())
+    {
+        if (const auto *changes = journal.undo())
+        {
+            changes_applied(*changes);
+        }
+    }
+}
+
+void WCM::redo()
+{
+    if (transaction_starts.empty())
+    {
+        if (const auto *changes = journal.redo())
+        {
+            changes_applied(*changes);
+        }
+    }
+}
+
+void WCM::changes_applied(const std::vector<ConfigChange> & changes)
+{
+    bool plugins_changed = false;
+    bool page_changed    = false;
+    std::set<wf_section> touched;
+    for (const auto & change : changes)
+    {
+        edit_started(change.section);
+    }
+
+    save_changes(changes);
+    for (const auto & change : changes)
+    {
+        touched.insert(change.section);
+        plugins_changed |= (change.section->get_name() == "core") &&
+            (change.option->get_name() == "plugins");
+        page_changed |= current_plugin && (get_config_section(current_plugin) == change.section);
+    }
+
+    // dynamic lists are built from the compound options, which only follow
+    // their entries when they are updated
+    for (auto & section : touched)
+    {
+        update_compound_options(section);
+    }
+
+    if (plugins_changed)
+    {
+        update_plugins_enabled();
+    }
+
+    // the widgets show the values from before the change, build them again
+    if (page_changed)
+    {
+        open_page(current_plugin);
+    }
+}
+
+void WCM::update_plugins_enabled()
+{
+    const auto plugins_str =
+        wf_config_mgr.get_section("core")->get_option("plugins")->get_value_str();
+    for (auto *plugin : plugins)
+    {
+        const bool enabled = plugin_enabled(plugin, plugins_str);
+        if (plugin->enabled != enabled)
+        {
+            plugin->enabled = enabled;
+            plugin->enabled_changed.emit();
+        }
+    }
+}
+
+void WCM::config_file_written(const ConfigWriter::write_result & result)
+{
+    const auto & file = result.path;
+    if (result.status == ConfigWriter::WRITE_NEEDS_FILE)
+    {
+        // the file could not be patched, write it from scratch
+        if (auto *mgr = find_config(file))
+        {
+            save_to_file({mgr, file, {}, true});
+        }
+
+        return;
+    }
+
+    const bool ok = (result.status == ConfigWriter::WRITE_OK);
+    if (ok)
+    {
+        disk_contents[file] = result.contents;
+        failed_writes.erase(file);
+        save_metrics.serialized(result.contents.size(), result.sections);
+    } else
+    {
+        failed_writes.insert(file);
+    }
+
+    // an older save may land while a newer one is queued
+    auto it = queued_saves.find(file);
+    if ((it == queued_saves.end()) || (it->second != result.serial))
+    {
+        return;
+    }
+
+    queued_saves.erase(it);
+    if (ok)
+    {
+        save_metrics.written(file);
+    } else
+    {
+        // the edits are not on disk, keep them out of the latencies
+        save_metrics.failed(file);
+    }
+
+    // every change made so far is on disk
+    if (queued_saves.empty() && failed_writes.empty() && pending_batches.empty() &&
+        !save_scheduler.pending())
+    {
+        config_writer.clear_log();
+    }
+
+    if (deferred_reloads.erase(file))
+    {
+        config_file_changed(file);
+    }
+}
+
+void WCM::config_file_changed(const std::string & file)
 {
-    // first try to find it in the user's local folders
-    std::string icon_path;
-    std::string xdg_data_dir;
-    char *c_xdg_data_dir = std::getenv("XDG_DATA_HOME");
-    char *c_user_home    = std::getenv("HOME");
+    // the change may be our own write, look again once it is done
+    if (queued_saves.count(file))
+    {
+        deferred_reloads.insert(file);
+        return;
+    }
 
-    if (c_xdg_data_dir != NULL)
+    auto contents = read_file(file);
+    if (!contents || (*contents == disk_contents[file]))
     {
-        xdg_data_dir = c_xdg_data_dir;
-    } else if (c_user_home != NULL)
+        return;
+    }
+
+    auto *mgr = find_config(file);
+    if (!mgr)
     {
-        xdg_data_dir = (std::string)c_user_home + "/.local/share/";
+        return;
     }
 
-    if (!xdg_data_dir.empty())
+    std::cout << "Reloading " << file << std::endl;
+    apply_external_changes(*mgr, disk_contents[file], *contents);
+    config_writer.load(file, *contents);
+    disk_contents[file] = std::move(*contents);
+}
+
+void WCM::apply_external_changes(wf::config::config_manager_t & mgr,
+    const std::string & old_contents, const std::string & new_contents)
+{
+    wf::config::config_manager_t old_config, new_config;
+    wf::config::load_configuration_options_from_string(old_config, old_contents);
+    wf::config::load_configuration_options_from_string(new_config, new_contents);
+
+    std::vector<std::shared_ptr<wf::config::option_base_t>> changed;
+    std::set<wf_section> touched;
+    // section and option names of everything changed, an empty option name
+    // for a whole section
+    std::set<std::pair<std::string, std::string>> reloaded;
+    bool structure_changed = false;
+
+    // Options of the metadata go back to their default value when they are
+    // removed from the file, entries of dynamic lists are removed with it.
+    // `new_section` is null if the whole section was removed.
+    auto remove_options = [&] (const wf_section & section, const wf_section & old_section,
+                               const wf_section & new_section)
+    {
+        for (auto & old_option : old_section->get_registered_options())
+        {
+            const auto & name = old_option->get_name();
+            auto option = section->get_option_or(name);
+            if (!option || (new_section && new_section->get_option_or(name)))
+            {
+                continue;
+            }
+
+            if (!wf::config::xml::get_option_xml_node(option))
+            {
+                section->unregister_option(option);
+                structure_changed = true;
+            } else
+            {
+                const auto value = option->get_default_value_str();
+                if ((option->get_value_str() == value) || !option->set_value_str(value))
+                {
+                    continue;
+                }
+
+                changed.push_back(option);
+            }
+
+            reloaded.insert({section->get_name(), name});
+            touched.insert(section);
+        }
+    };
+
+    for (auto & new_section : new_config.get_all_sections())
     {
-        icon_path = xdg_data_dir + "/wayfire/icons/" + name;
-        if (std::filesystem::exists(icon_path))
+        const auto section_name = new_section->get_name();
+        auto section     = mgr.get_section(section_name);
+        auto old_section = old_config.get_section(section_name);
+        if (!section)
         {
-            return icon_path;
+            mgr.merge_section(new_section);
+            reloaded.insert({section_name, ""});
+            structure_changed = true;
+            continue;
         }
+
+        for (auto & new_option : new_section->get_registered_options())
+        {
+            const auto & name = new_option->get_name();
+            const auto value  = new_option->get_value_str();
+            auto old_option   = old_section ? old_section->get_option_or(name) : nullptr;
+            // options which changed only in WCM keep their value
+            if (old_option && (old_option->get_value_str() == value))
+            {
+                continue;
+            }
+
+            auto option = section->get_option_or(name);
+            if (!option)
+            {
+                section->register_new_option(new_option);
+                structure_changed = true;
+            } else if ((option->get_value_str() == value) || !option->set_value_str(value))
+            {
+                continue;
+            }
+
+            changed.push_back(option ? option : new_option);
+            reloaded.insert({section_name, name});
+            touched.insert(section);
+        }
+
+        if (old_section)
+        {
+            remove_options(section, old_section, new_section);
+        }
+    }
+
+    for (auto & old_section : old_config.get_all_sections())
+    {
+        const auto section_name = old_section->get_name();
+        auto section = mgr.get_section(section_name);
+        if (section && !new_config.get_section(section_name))
+        {
+            remove_options(section, old_section, nullptr);
+        }
+    }
+
+    for (auto & section : touched)
+    {
+        update_compound_options(section);
+    }
+
+    // undo and redo would overwrite the reloaded values with stale ones
+    journal.forget(reloaded);
+
+    const auto page_section = current_plugin ? get_config_section(current_plugin) : nullptr;
+    bool rebuild_page = structure_changed && touched.count(page_section);
+    bool plugins_changed = false;
+    showing_external_changes = true;
+    for (auto & option : changed)
+    {
+        auto [begin, end] = option_widgets.equal_range(option.get());
+        for (auto it = begin; it != end; ++it)
+        {
+            it->second->show_value(option->get_value_str());
+        }
+
+        // entries of dynamic lists have no widget of their own
+        rebuild_page |= (begin == end) && page_section &&
+            (page_section->get_option_or(option->get_name()) == option);
+        plugins_changed |= (option == wf_config_mgr.get_section("core")->get_option_or("plugins"));
+    }
+
+    showing_external_changes = false;
+    if (plugins_changed)
+    {
+        update_plugins_enabled();
     }
 
-    if (std::filesystem::exists(WAYFIRE_ICONDIR "/" + name))
+    if (rebuild_page)
     {
-        return WAYFIRE_ICONDIR "/" + name;
+        open_page(current_plugin);
     }
+}
+
+void WCM::add_option_widget(const wf::config::option_base_t *option, OptionWidget *widget)
+{
+    option_widgets.emplace(option, widget);
+}
 
-    return WCM_ICONDIR "/" + name;
+void WCM::remove_option_widget(const wf::config::option_base_t *option, OptionWidget *widget)
+{
+    auto [begin, end] = option_widgets.equal_range(option);
+    for (auto it = begin; it != end; ++it)
+    {
+        if (it->second == widget)
+        {
+            option_widgets.erase(it);
+            return;
+        }
+    }
+}
+
+void WCM::edit_started(const wf_section & section)
+{
+    const std::string *file;
+    if (find_config(section, &file))
+    {
+        save_metrics.edit(*file);
+    }
+}
+
+void WCM::record_change(ConfigChange change)
+{
+    // the latency of the save includes syncing the log
+    edit_started(change.section);
+    begin();
+    change.apply();
+    pending_changes.push_back(std::move(change));
+    commit();
+}
+
+void WCM::set_option(const wf_section & section, const std::string & name,
+    const std::string & value)
+{
+    auto option = section->get_option(name);
+    auto old_value = option->get_value_str();
+    // widgets also report values they were only initialized with, or
+    // which were just loaded from the file
+    if ((old_value != value) && !showing_external_changes)
+    {
+        record_change({ConfigChange::SET_VALUE, section, option, std::move(old_value), value});
+    }
+}
+
+void WCM::register_option(const wf_section & section,
+    const std::shared_ptr<wf::config::option_base_t> & option)
+{
+    record_change({ConfigChange::REGISTER, section, option});
+}
+
+void WCM::unregister_option(const wf_section & section,
+    const std::shared_ptr<wf::config::option_base_t> & option)
+{
+    if (option)
+    {
+        record_change({ConfigChange::UNREGISTER, section, option});
+    }
+}
+
+std::shared_ptr<wf::config::section_t> WCM::get_config_section(Plugin *plugin)
+{
+    if (plugin->type == PLUGIN_TYPE_WAYFIRE)
+    {
+        return wf_config_mgr.get_section(plugin->name);
+    }
+
+#ifdef HAVE_WFSHELL
+    if (plugin->type == PLUGIN_TYPE_WF_SHELL)
+    {
+        return wf_shell_config_mgr.get_section(plugin->name);
+    }
+
+#endif
+    return nullptr;
+}
+
+std::string WCM::find_icon(const std::string & name)
+{
+    return icon_index.find(name);
+}
+
+bool WCM::load_icon(const std::string & name, int size, const IconLoader::slot_loaded & callback)
+{
+    const auto icon_path = find_icon(name);
+    if (icon_path.empty())
+    {
+        return false;
+    }
+
+    icon_loader.load(icon_path, size, callback);
+    return true;
 }
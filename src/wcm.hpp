@@ -33,6 +33,8 @@
 #include <iostream>
 #include <fmt/core.h>
 #include <libintl.h>
+#include <map>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 #include <wayfire/config/file.hpp>
@@ -40,6 +42,13 @@
 #include <keyboard-shortcuts-inhibit-unstable-v1-client-protocol.h>
 #include <glibmm/i18n.h>
 
+#include "cache.hpp"
+#include "changes.hpp"
+#include "icons.hpp"
+#include "metrics.hpp"
+#include "probe.hpp"
+#include "save.hpp"
+#include "watch.hpp"
 #include "metadata.hpp"
 
 struct animate_option
@@ -57,6 +66,36 @@ class MainPage : public Gtk::ScrolledWindow
     void set_filter(const Glib::ustring & filter);
 
   private:
+    /* Item of the list models behind the category flowboxes */
+    class PluginItem : public Glib::Object
+    {
+      public:
+        Plugin *const plugin;
+
+        static inline Glib::RefPtr<PluginItem> create(Plugin *plugin)
+        {
+            return Glib::RefPtr<PluginItem>(new PluginItem(plugin));
+        }
+
+      protected:
+        PluginItem(Plugin *plugin) : plugin(plugin)
+        {}
+    };
+
+    /* Widget of a plugin, created by the flowbox for each item */
+    class PluginWidget : public Gtk::Box
+    {
+        Plugin *plugin;
+        Gtk::CheckButton enabled_check;
+        Gtk::Button button;
+        Gtk::Box button_layout = Gtk::Box(Gtk::ORIENTATION_HORIZONTAL, 5);
+        Gtk::Image icon;
+        Gtk::Label label;
+
+      public:
+        PluginWidget(Plugin *plugin);
+    };
+
     struct Category
     {
         Glib::ustring name;
@@ -67,16 +106,17 @@ class MainPage : public Gtk::ScrolledWindow
         Gtk::Image image;
         Gtk::Label label;
 
+        Glib::RefPtr<Gio::ListStore<PluginItem>> store = Gio::ListStore<PluginItem>::create();
         Gtk::FlowBox flowbox;
 
         Category(const Glib::ustring & name_string, const Glib::ustring & icon_name);
-        void add_plugin(Plugin *plugin);
     };
 
+    bool plugin_visible(Plugin *plugin) const;
+
     const std::vector<Plugin*> & plugins;
+    Glib::ustring filter;
     Gtk::Box vbox = Gtk::Box(Gtk::ORIENTATION_VERTICAL, 10);
-    Glib::RefPtr<Gtk::SizeGroup> size_group = Gtk::SizeGroup::create(
-        Gtk::SIZE_GROUP_BOTH);
     std::array<Gtk::Separator, NUM_CATEGORIES - 1> separators;
     std::array<Category, NUM_CATEGORIES> categories = {
         Category{_("General"), "preferences-system"},
@@ -156,6 +196,9 @@ class OptionWidget : public Gtk::Box
     std::unique_ptr<Gtk::SpinButton> animate_spin_button, int_spin_button;
     std::unique_ptr<Gtk::ComboBoxText> animate_combo_box;
     animate_option ao;
+    std::shared_ptr<wf::config::option_base_t> config_option;
+    // shows a value set from outside of the widget
+    sigc::slot<void, const std::string&> value_setter;
 
     inline void pack_end(std::unique_ptr<Gtk::Widget> && widget, bool expand = false,
         bool fill = false)
@@ -167,6 +210,10 @@ class OptionWidget : public Gtk::Box
   public:
     OptionWidget(Option *option);
     ~OptionWidget();
+    /*!
+     * Show `value`, after the option was changed outside of WCM.
+     */
+    void show_value(const std::string & value);
 };
 
 class DynamicListBase : public Gtk::Box
@@ -308,7 +355,82 @@ class WCM
     void parse_config(wf::config::config_manager_t & config_manager);
     bool init_input_inhibitor();
     void create_main_layout();
-    void save_to_file(wf::config::config_manager_t & mgr, const std::string & file);
+    void save_to_file(const SaveRequest & request);
+    /*!
+     * Rebuild the values of the compound options of `section` from the
+     * options holding their entries.
+     */
+    void update_compound_options(const std::shared_ptr<wf::config::section_t> & section);
+    /*!
+     * Start the save latency of an edit to `section`.
+     */
+    void edit_started(const wf_section & section);
+    void record_change(ConfigChange change);
+    /*!
+     * Save the sections touched by an undo or redo, and bring the UI up to
+     * date with them.
+     */
+    void changes_applied(const std::vector<ConfigChange> & changes);
+    void update_plugins_enabled();
+    /*!
+     * Returns the config holding `section` and sets `file` to its path, or
+     * returns nullptr if `section` belongs to no config.
+     */
+    wf::config::config_manager_t *find_config(const wf_section & section,
+        const std::string **file);
+    wf::config::config_manager_t *find_config(const std::string & file);
+    /*!
+     * Log `changes`, one transaction, to the write-ahead log and schedule
+     * saving them once the log is on disk.
+     */
+    void save_changes(const std::vector<ConfigChange> & changes);
+    void changes_logged(uint64_t batch, bool ok);
+    /*!
+     * Apply the changes a previous run logged but may not have saved.
+     */
+    void replay_unsaved_changes();
+    void config_file_written(const ConfigWriter::write_result & result);
+    /*!
+     * Load the changes made to `file` outside of WCM.
+     */
+    void config_file_changed(const std::string & file);
+    /*!
+     * Apply to `mgr` the options which differ between two versions of its
+     * config file, including options and sections removed from it. Options
+     * changed only in WCM since `old_contents` keep their value.
+     */
+    void apply_external_changes(wf::config::config_manager_t & mgr,
+        const std::string & old_contents, const std::string & new_contents);
+
+    // startup and save measurements, enabled from the command line
+    StartupProfiler profiler;
+    SaveMetrics save_metrics;
+    sigc::connection first_frame_connection;
+
+    // Saving, reloading and undoing changes. Destroying the widgets can
+    // record changes, so these are declared before the widgets as well.
+    ConfigWriter config_writer;
+    SaveScheduler save_scheduler;
+    ConfigWatcher config_watcher;
+    // last contents known to be on disk for each file
+    std::unordered_map<std::string, std::string> disk_contents;
+    // serial of the newest save of each file not written yet
+    std::unordered_map<std::string, uint64_t> queued_saves;
+    // files changed while our own write was in flight
+    std::set<std::string> deferred_reloads;
+    // files whose last write failed, their changes are only in the log
+    std::set<std::string> failed_writes;
+    // saves of the transactions whose log batch is not on disk yet
+    std::map<uint64_t, std::vector<SaveRequest>> pending_batches;
+    // newest batch whose saves were scheduled
+    uint64_t last_released = 0;
+    // compound options of each section, found on its first save
+    std::unordered_map<const wf::config::section_t*,
+        std::vector<wf::config::compound_option_t*>> compound_options;
+    // changes of the open transactions, and the index of the first change of each
+    std::vector<ConfigChange> pending_changes;
+    std::vector<size_t> transaction_starts;
+    ChangeJournal journal;
 
     // these objects can be used when widgets are destroyed and emit `signal_changed`
     // causing saving config
@@ -317,9 +439,21 @@ class WCM
     wf::config::config_manager_t wf_shell_config_mgr;
     std::string wf_config_file;
     std::string wf_shell_config_file;
+    // widgets showing each option, to show values loaded from the files
+    std::unordered_multimap<const wf::config::option_base_t*, OptionWidget*> option_widgets;
+    bool showing_external_changes = false;
+
     std::string start_plugin;
     std::vector<Plugin*> plugins;
 
+    MetadataCache metadata_cache;
+    // next plugin to add to the metadata cache
+    size_t cache_index = 0;
+    IconIndex icon_index;
+    IconLoader icon_loader;
+    ProgramProbe program_probe;
+    std::string output_config_program;
+
     Plugin *current_plugin = nullptr;
 
     std::unique_ptr<Gtk::ApplicationWindow> window;
@@ -349,12 +483,14 @@ class WCM
     cairo_surface_t *grab_window_surface = nullptr;
     zwp_keyboard_shortcuts_inhibitor_v1 *shortcuts_inhibitor     = nullptr;
     zwp_keyboard_shortcuts_inhibit_manager_v1 *inhibitor_manager = nullptr;
+    bool registry_synced = false;
 
     // WCM is a singleton
     static inline WCM *instance = nullptr;
 
   public:
     WCM(Glib::RefPtr<Gtk::Application> app);
+    ~WCM();
     static inline WCM *get_instance()
     {
         if (instance == nullptr)
@@ -367,17 +503,40 @@ class WCM
     }
 
     void open_page(Plugin *plugin = nullptr);
+    /*!
+     * Write pending changes, close the window and leave the main loop, so
+     * that shutdown handlers run.
+     */
+    void quit();
 
     void set_plugin_enabled(Plugin *plugin, bool enabled);
+    /*!
+     * Returns the path of the icon file, or an empty string if it is not
+     * installed.
+     */
     std::string find_icon(const std::string & icon_name);
+    /*!
+     * Decode the icon at `size` pixels in the background and pass it to
+     * `callback` on the main thread. Returns false if the icon is not
+     * installed.
+     */
+    bool load_icon(const std::string & icon_name, int size,
+        const IconLoader::slot_loaded & callback);
 
     void load_config_files();
+    inline const std::vector<Plugin*> & get_plugins() const
+    {
+        return plugins;
+    }
+
     inline void parse_config()
     {
         parse_config(wf_config_mgr);
     }
 
     std::shared_ptr<wf::config::section_t> get_config_section(Plugin *plugin);
+    void add_option_widget(const wf::config::option_base_t *option, OptionWidget *widget);
+    void remove_option_widget(const wf::config::option_base_t *option, OptionWidget *widget);
 #if HAVE_WFSHELL
     inline void parse_wfshell_config()
     {
@@ -385,7 +544,41 @@ class WCM
     }
 
 #endif
-    bool save_config(Plugin *plugin);
+    /*!
+     * Schedule a write of `section` to its config file, see SaveScheduler.
+     */
+    bool save_config(const wf_section & section);
+    /*!
+     * Write all scheduled changes now.
+     */
+    void flush_config();
+
+    /*!
+     * Start a transaction. The changes made through set_option(),
+     * register_option() and unregister_option() until the matching commit()
+     * are saved together, with one compound option rebuild and one write per
+     * file. Transactions can be nested, the changes are saved when the
+     * outermost one is committed. Outside of a transaction every change is
+     * saved on its own.
+     */
+    void begin();
+    void commit();
+    /*!
+     * Undo or redo the last committed transaction. Does nothing while a
+     * transaction is open.
+     */
+    void undo();
+    void redo();
+
+    void set_option(const wf_section & section, const std::string & name,
+        const std::string & value);
+    void register_option(const wf_section & section,
+        const std::shared_ptr<wf::config::option_base_t> & option);
+    /*!
+     * Does nothing if `option` is null.
+     */
+    void unregister_option(const wf_section & section,
+        const std::shared_ptr<wf::config::option_base_t> & option);
 
     inline std::string get_xkb_rules()
     {
@@ -397,6 +590,11 @@ class WCM
         inhibitor_manager = value;
     }
 
+    /*!
+     * Called once the compositor has announced all globals.
+     */
+    void set_registry_synced();
+
     bool lock_input(Gtk::Dialog *grab_dialog);
     void unlock_input();
     Plugin *find_plugin_by_name(std::vector<Plugin*> plugins, std::string search_name);